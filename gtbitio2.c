@@ -172,6 +172,28 @@ void pfputc( int c )
 	}
 }
 
+/* Puts n bytes into the output buffer; as pfputc(), at a byte boundary. */
+void pfwrite( unsigned char *s, unsigned int n )
+{
+	unsigned int k;
+	
+	while ( n ) {
+		k = pBUFSIZE - pbuf_count;
+		if ( k > n ) k = n;
+		memcpy( pbuf, s, k );
+		pbuf += k;
+		s += k;
+		n -= k;
+		if ( (pbuf_count += k) == pBUFSIZE ){
+			fwrite( pbuf_start, pBUFSIZE, 1, pOUT );
+			pbuf = pbuf_start;
+			pbuf_count = 0;
+			nbytes_out += pBUFSIZE;
+			memset( pbuf, 0, pBUFSIZE );
+		}
+	}
+}
+
 /* Multiple Bit Input/Output (2003/2004) */
 
 /* input more bits at a time; is faster. */
@@ -81,6 +81,7 @@ void flush_put_buffer( void );
 int  get_bit( void );
 int  gfgetc( void );
 void pfputc( int c );
+void pfwrite( unsigned char *s, unsigned int n );
 unsigned int get_nbits( int size );
 void put_nbits( unsigned int k, int size );
 int get_symbol( int size );
@@ -1,21 +1,382 @@
 /*
-	Filename:  GTBITIO3.C, Ver. 3, 8/22/2022, 6/27/2023
+	Filename:  GTBITIO3.C, Ver. 3, 8/22/2022, 6/27/2023, 10/16/2026
 	Author:    Gerald R. Tamayo
 	Written:   (2000/2003/2008/2022)
+	
+	(10/16/2026) Output bits are accumulated in p_byte and assigned,
+	not ORed, into pbuf; the put buffer is no longer memset().
+	
+	(10/16/2026) All reads go through fill_get_buffer() and all writes
+	through write_put_buffer(). With GT_ASYNC_IO defined (link with
+	-lpthread), a reader and a writer thread do the file I/O on a
+	ring of GT_NBUFS buffers per direction, while the coder works on
+	the current one.
+	
+	(10/16/2026) With GT_URING also defined (Linux), regular files are
+	read and written with io_uring (gturing.c) instead of the threads:
+	the ring's reads are queued ahead at file offsets, and its writes
+	stay in flight until the buffer comes round again. Pipes and
+	kernels without io_uring fall back to the threads.
+	
+	(10/16/2026) init_get_memory() and init_put_memory() read from and
+	write to the caller's memory instead of gIN and pOUT; the buffers
+	then point straight into it (see lzuf.c).
+	
+	(10/16/2026) The module's state is GT_TLS (gttls.h): per thread
+	with GT_REENTRANT. The reader and writer threads get their ring
+	as the argument.
+	
+	(10/16/2026) g_source and p_sink, when set, are called in place of
+	fread(gIN) and fwrite(pOUT): a source returns up to n bytes (0 at
+	end of input), a sink takes all n (see the lzuf.c streams).
+	
+	(10/17/2026) g_source and p_sink removed: the lzuf.c streams code
+	whole blocks in memory now.
 */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>  /* C99 */
 #include "gtbitio3.h"
+#ifdef GT_URING
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include "gturing.c"
+#endif
+
+GT_TLS FILE *gIN = NULL, *pOUT = NULL;
+GT_TLS unsigned int pBUFSIZE = 8192, gBUFSIZE = 8192;
+GT_TLS unsigned char *pbuf = NULL, *pbuf_start = NULL, p_cnt = 0, p_byte = 0;
+GT_TLS unsigned char *gbuf = NULL, *gbuf_start = NULL, *gbuf_end = NULL, g_cnt = 0;
+GT_TLS unsigned int bit_read = 0, nbits_read = 0;
+GT_TLS unsigned int pbuf_count = 0, nfread = 0;
+GT_TLS int64_t nbytes_out = 0, nbytes_read = 0;
+
+/* the caller's memory, in place of gIN and pOUT. */
+GT_TLS unsigned char *g_mem = NULL, *p_mem = NULL;
+GT_TLS size_t g_mem_left = 0, p_mem_left = 0;
+GT_TLS int p_mem_full = 0;   /* the output didn't fit. */
+static GT_TLS unsigned char g_mem_end = 0;        /* gbuf past the input. */
+static GT_TLS unsigned char p_mem_spill[ 64 ];    /* pbuf past the output room. */
+
+/* the caller's functions, in place of gIN and pOUT. */
+
+#ifdef GT_ASYNC_IO
+/*
+A ring of GT_NBUFS buffers. The coder holds buffer cur; for the
+get ring, the count buffers after cur have been read ahead, and
+for the put ring, the count buffers before cur wait to be written.
+*/
+typedef struct {
+	unsigned char *buf[ GT_NBUFS ];
+	unsigned int len[ GT_NBUFS ];
+	int cur, count;
+	int eof, stop;
+	int started, uring;  /* a thread, or io_uring, does the I/O. */
+	FILE *f;                /* the thread's file, */
+	unsigned int bufsize;   /* and the size of its reads. */
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+#ifdef GT_URING
+	gt_uring_t u;
+	int fd;
+	int64_t off, size;          /* the next file offset; the input size. */
+	int64_t pos[ GT_NBUFS ];    /* the file offset of each buffer. */
+	int pending[ GT_NBUFS ];    /* I/O in flight on the buffer. */
+#endif
+} gt_ring_t;
+
+GT_TLS gt_ring_t g_ring, p_ring;
+
+static unsigned char *alloc_ring( gt_ring_t *r, unsigned int size )
+{
+	int i;
+	
+	for ( i = 0; i < GT_NBUFS; i++ ) {
+		r->buf[i] = (unsigned char *) malloc( sizeof(char) * size );
+		if ( !r->buf[i] ) {
+			fprintf(stderr, "\nmemory allocation error!");
+			exit(0);
+		}
+		r->len[i] = 0;
+	}
+	r->bufsize = size;
+	r->cur = 0;
+	r->count = 0;
+	r->eof = 0;
+	r->stop = 0;
+	r->started = 0;
+	r->uring = 0;
+	pthread_mutex_init( &r->lock, NULL );
+	pthread_cond_init( &r->cond, NULL );
+	return r->buf[0];
+}
+
+/*
+The thread gets r itself; its own copy of the TLS state is not the
+coder's. If there is no thread, the ring reads and writes r->f
+itself, one buffer at a time.
+*/
+static void start_thread( gt_ring_t *r, void *(*fn)( void * ), FILE *f )
+{
+	r->f = f;
+	r->started = pthread_create( &r->thread, NULL, fn, r ) == 0;
+}
+
+#ifdef GT_URING
+/* completes a short read or write with plain system calls. */
+static void uring_rest( gt_ring_t *r, int i, unsigned int done )
+{
+	ssize_t n;
+	
+	while ( done < r->len[i] ) {
+		if ( r == &p_ring ) n = pwrite( r->fd, r->buf[i]+done, r->len[i]-done, r->pos[i]+done );
+		else n = pread( r->fd, r->buf[i]+done, r->len[i]-done, r->pos[i]+done );
+		if ( n == 0 && r == &g_ring ) {
+			r->len[i] = done;  /* the file got shorter. */
+			break;
+		}
+		if ( n <= 0 ) {
+			fprintf(stderr, "\nI/O error!");
+			exit(0);
+		}
+		done += n;
+	}
+}
+
+/* waits until the I/O on buffer i is complete; if the ring fails, does all of it here. */
+static void uring_wait( gt_ring_t *r, int i )
+{
+	int j, res;
+	
+	while ( r->pending[i] ) {
+		j = gt_uring_wait( &r->u, &res );
+		if ( j < 0 ) {
+			for ( j = 0; j < GT_NBUFS; j++ ) {
+				if ( r->pending[j] ) {
+					r->pending[j] = 0;
+					uring_rest( r, j, 0 );
+				}
+			}
+			break;
+		}
+		r->pending[j] = 0;
+		uring_rest( r, j, res < 0 ? 0 : res );
+	}
+}
+
+static void uring_drain( gt_ring_t *r )
+{
+	int i;
+	
+	for ( i = 0; i < GT_NBUFS; i++ ) uring_wait( r, i );
+}
+
+static void uring_free( gt_ring_t *r )
+{
+	gt_uring_free( &r->u );
+	r->uring = 0;
+}
+
+/* queues the read of the next input buffer into buffer i. */
+static void uring_read( int i )
+{
+	int64_t n = g_ring.size - g_ring.off;
+	
+	if ( n > gBUFSIZE ) n = gBUFSIZE;
+	if ( n < 0 ) n = 0;
+	g_ring.len[i] = (unsigned int) n;
+	g_ring.pos[i] = g_ring.off;
+	if ( n ) {
+		g_ring.pending[i] = gt_uring_submit( &g_ring.u, 0, g_ring.fd, i, g_ring.buf[i], (unsigned) n, g_ring.off );
+		if ( !g_ring.pending[i] ) uring_rest( &g_ring, i, 0 );
+		g_ring.off += n;
+	}
+}
+
+/*
+Uses io_uring for a regular file. The FILE is not read or
+written past its current position; after the put ring,
+seek before writing to the FILE again.
+*/
+static int start_uring( gt_ring_t *r, FILE *f, unsigned int size )
+{
+	struct stat st;
+	int i;
+	
+	if ( fstat( fileno(f), &st ) != 0 || !S_ISREG( st.st_mode ) ) return 0;
+	if ( !gt_uring_init( &r->u, GT_NBUFS, r->buf, GT_NBUFS, size ) ) return 0;
+	r->uring = 1;
+	r->fd = fileno(f);
+	r->size = st.st_size;
+	memset( r->pending, 0, sizeof(r->pending) );
+	if ( r == &g_ring ) {
+		r->off = ftello( f );
+		for ( i = 0; i < GT_NBUFS-1; i++ ) uring_read( i );
+	}
+	else r->off = -1;  /* set at the first write. */
+	return 1;
+}
+
+/* the buffer just used reads ahead; the next one must be in. */
+static void uring_fill( void )
+{
+	uring_read( g_ring.cur );
+	g_ring.cur = (g_ring.cur + 1) % GT_NBUFS;
+	uring_wait( &g_ring, g_ring.cur );
+	gbuf_start = g_ring.buf[ g_ring.cur ];
+	nfread = g_ring.len[ g_ring.cur ];
+}
+
+/* queues the write of n bytes of the current put buffer; waits for the next buffer's last write. */
+static void uring_put( unsigned int n )
+{
+	int i = p_ring.cur;
+	
+	if ( p_ring.off < 0 ) {  /* after what the FILE has written. */
+		fflush( pOUT );
+		p_ring.off = ftello( pOUT );
+	}
+	p_ring.len[i] = n;
+	p_ring.pos[i] = p_ring.off;
+	p_ring.pending[i] = gt_uring_submit( &p_ring.u, 1, p_ring.fd, i, p_ring.buf[i], n, p_ring.off );
+	if ( !p_ring.pending[i] ) uring_rest( &p_ring, i, 0 );
+	p_ring.off += n;
+	p_ring.cur = (i + 1) % GT_NBUFS;
+	uring_wait( &p_ring, p_ring.cur );
+	pbuf_start = p_ring.buf[ p_ring.cur ];
+}
+#else
+	/* the rings always use the threads. */
+	#define start_uring( r, f, size )  0
+	#define uring_drain( r )
+	#define uring_free( r )
+	#define uring_fill()
+	#define uring_put( n )
+#endif
+
+static void free_ring( gt_ring_t *r )
+{
+	int i;
+	
+	if ( !r->buf[0] ) return;  /* not started. */
+	if ( r->uring ) {
+		uring_drain( r );
+		uring_free( r );
+	}
+	if ( r->started ) {
+		pthread_mutex_lock( &r->lock );
+		r->stop = 1;
+		pthread_cond_broadcast( &r->cond );
+		pthread_mutex_unlock( &r->lock );
+		pthread_join( r->thread, NULL );
+		r->started = 0;
+	}
+	pthread_mutex_destroy( &r->lock );
+	pthread_cond_destroy( &r->cond );
+	for ( i = 0; i < GT_NBUFS; i++ ) {
+		free( r->buf[i] );
+		r->buf[i] = NULL;
+	}
+}
 
-FILE *gIN = NULL, *pOUT = NULL;
-unsigned int pBUFSIZE = 8192, gBUFSIZE = 8192;
-unsigned char *pbuf = NULL, *pbuf_start = NULL, p_cnt = 0;
-unsigned char *gbuf = NULL, *gbuf_start = NULL, *gbuf_end = NULL, g_cnt = 0;
-unsigned int bit_read = 0, nbits_read = 0;
-unsigned int pbuf_count = 0, nfread = 0;
-int64_t nbytes_out = 0, nbytes_read = 0;
+/* reads ahead into the free buffers of the get ring. */
+static void *gt_reader( void *arg )
+{
+	gt_ring_t *r = (gt_ring_t *) arg;
+	unsigned int n;
+	int i;
+	
+	pthread_mutex_lock( &r->lock );
+	while ( !r->stop ) {
+		if ( r->eof || r->count == GT_NBUFS-1 ) {
+			pthread_cond_wait( &r->cond, &r->lock );
+			continue;
+		}
+		i = (r->cur + 1 + r->count) % GT_NBUFS;
+		pthread_mutex_unlock( &r->lock );
+		n = fread( r->buf[i], 1, r->bufsize, r->f );
+		pthread_mutex_lock( &r->lock );
+		r->len[i] = n;
+		r->count++;
+		if ( n < r->bufsize ) r->eof = 1;
+		pthread_cond_broadcast( &r->cond );
+	}
+	pthread_mutex_unlock( &r->lock );
+	return arg;
+}
+
+/* writes the buffers handed over to the put ring, oldest first. */
+static void *gt_writer( void *arg )
+{
+	gt_ring_t *r = (gt_ring_t *) arg;
+	unsigned int n;
+	int i;
+	
+	pthread_mutex_lock( &r->lock );
+	while ( r->count || !r->stop ) {
+		if ( r->count == 0 ) {
+			pthread_cond_wait( &r->cond, &r->lock );
+			continue;
+		}
+		i = (r->cur - r->count + GT_NBUFS) % GT_NBUFS;
+		n = r->len[i];
+		pthread_mutex_unlock( &r->lock );
+		fwrite( r->buf[i], 1, n, r->f );
+		pthread_mutex_lock( &r->lock );
+		r->count--;
+		pthread_cond_broadcast( &r->cond );
+	}
+	pthread_mutex_unlock( &r->lock );
+	return arg;
+}
+
+/* takes the next buffer the reader has filled. */
+static void get_ring( void )
+{
+	if ( !g_ring.started ) {  /* no reader thread. */
+		nfread = fread( gbuf_start, 1, g_ring.bufsize, g_ring.f );
+		return;
+	}
+	pthread_mutex_lock( &g_ring.lock );
+	while ( g_ring.count == 0 && !g_ring.eof ) {
+		pthread_cond_wait( &g_ring.cond, &g_ring.lock );
+	}
+	if ( g_ring.count ) {
+		g_ring.cur = (g_ring.cur + 1) % GT_NBUFS;
+		g_ring.count--;
+		gbuf_start = g_ring.buf[ g_ring.cur ];
+		nfread = g_ring.len[ g_ring.cur ];
+		pthread_cond_broadcast( &g_ring.cond );
+	}
+	else nfread = 0;
+	pthread_mutex_unlock( &g_ring.lock );
+}
+
+/* hands n bytes of the current put buffer to the writer; gets the next buffer. */
+static void put_ring( unsigned int n )
+{
+	if ( p_ring.uring ) {
+		uring_put( n );
+		return;
+	}
+	if ( !p_ring.started ) {  /* no writer thread. */
+		fwrite( pbuf_start, 1, n, p_ring.f );
+		return;
+	}
+	pthread_mutex_lock( &p_ring.lock );
+	p_ring.len[ p_ring.cur ] = n;
+	p_ring.count++;
+	p_ring.cur = (p_ring.cur + 1) % GT_NBUFS;
+	pthread_cond_broadcast( &p_ring.cond );
+	while ( p_ring.count == GT_NBUFS ) {
+		pthread_cond_wait( &p_ring.cond, &p_ring.lock );
+	}
+	pbuf_start = p_ring.buf[ p_ring.cur ];
+	pthread_mutex_unlock( &p_ring.lock );
+}
+#endif
 
 void init_buffer_sizes( unsigned int size )
 {
@@ -25,11 +386,16 @@ void init_buffer_sizes( unsigned int size )
 void init_put_buffer( void )
 {
 	p_cnt = 0;
+	p_byte = 0;
 	pbuf = NULL;
 	pbuf_start = NULL;
 	pbuf_count = 0;
 	nbytes_out = 0;
 
+#ifdef GT_ASYNC_IO
+	pbuf = pbuf_start = alloc_ring( &p_ring, pBUFSIZE );
+	if ( !start_uring( &p_ring, pOUT, pBUFSIZE ) ) start_thread( &p_ring, gt_writer, pOUT );
+#else
 	/* Allocate MEMORY for BUFFERS. */
 	while ( 1 ) {
 		pbuf = (unsigned char *) malloc( sizeof(char) * pBUFSIZE );
@@ -45,7 +411,7 @@ void init_put_buffer( void )
 			}
 		}
 	}
-	memset( pbuf, 0, pBUFSIZE );
+#endif
 }
 
 void init_get_buffer( void )
@@ -56,6 +422,11 @@ void init_get_buffer( void )
 	g_cnt = 0, nfread = 0;
 	nbytes_read = 0;
 	
+#ifdef GT_ASYNC_IO
+	gbuf = gbuf_start = alloc_ring( &g_ring, gBUFSIZE );
+	g_ring.cur = GT_NBUFS-1;  /* the reader starts with buffer 0. */
+	if ( !start_uring( &g_ring, gIN, gBUFSIZE ) ) start_thread( &g_ring, gt_reader, gIN );
+#else
 	/* Allocate MEMORY for BUFFERS. */
 	while ( 1 ) {
 		gbuf = (unsigned char *) malloc( sizeof(char) * gBUFSIZE );
@@ -71,30 +442,152 @@ void init_get_buffer( void )
 			}
 		}
 	}
-	nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-	gbuf_end = (unsigned char *) (gbuf + nfread);
+#endif
+	fill_get_buffer();
 }
 
 void free_put_buffer( void )
 {
+#ifdef GT_ASYNC_IO
+	free_ring( &p_ring );
+#else
 	pbuf = pbuf_start;
 	if ( pbuf ) free( pbuf );
+#endif
+	pbuf = pbuf_start = NULL;
 }
 
 void free_get_buffer( void )
 {
+#ifdef GT_ASYNC_IO
+	free_ring( &g_ring );
+#else
 	gbuf = gbuf_start;
 	if ( gbuf ) free( gbuf );
+#endif
+	gbuf = gbuf_start = NULL;
+}
+
+/* the next piece of the input in memory. */
+static void get_memory( void )
+{
+	nfread = g_mem_left > GT_MEM_CHUNK ? GT_MEM_CHUNK : (unsigned int) g_mem_left;
+	gbuf_start = nfread ? g_mem : &g_mem_end;
+	g_mem += nfread;
+	g_mem_left -= nfread;
+}
+
+/* keeps n bytes of the put buffer in memory; the buffer moves past them. */
+static void put_memory( unsigned int n )
+{
+	if ( pbuf_start == p_mem_spill ) {
+		if ( n ) p_mem_full = 1;  /* out of room. */
+		return;
+	}
+	p_mem += n;
+	p_mem_left -= n;
+	pbuf_start = p_mem;
+	pBUFSIZE = p_mem_left > GT_MEM_CHUNK ? GT_MEM_CHUNK : (unsigned int) p_mem_left;
+	if ( pBUFSIZE == 0 ) {
+		pbuf_start = p_mem_spill;
+		pBUFSIZE = sizeof(p_mem_spill);
+	}
+}
+
+/* reads from the n bytes at p instead of gIN. */
+void init_get_memory( unsigned char *p, size_t n )
+{
+	g_mem = p;
+	g_mem_left = n;
+	g_cnt = 0, nfread = 0;
+	nbytes_read = 0;
+	fill_get_buffer();
+}
+
+/* writes to the n bytes at p instead of pOUT; p_mem_full is set if they are not enough. */
+void init_put_memory( unsigned char *p, size_t n )
+{
+	p_mem = p;
+	p_mem_left = n;
+	p_mem_full = 0;
+	p_cnt = 0;
+	p_byte = 0;
+	pbuf_start = NULL;
+	put_memory( 0 );
+	pbuf = pbuf_start;
+	pbuf_count = 0;
+	nbytes_out = 0;
+}
+
+/* back to gIN and pOUT. */
+void free_memory_io( void )
+{
+	if ( g_mem ) gbuf = gbuf_start = gbuf_end = NULL;
+	if ( p_mem ) pbuf = pbuf_start = NULL;
+	g_mem = p_mem = NULL;
+	g_mem_left = p_mem_left = 0;
+}
+
+/* gets the next buffer of input; nfread == 0 at end of file. */
+void fill_get_buffer( void )
+{
+	nbytes_read += nfread;
+	if ( g_mem ) get_memory();
+	else {
+#ifdef GT_ASYNC_IO
+		if ( g_ring.uring ) uring_fill();
+		else get_ring();
+#else
+		nfread = fread ( gbuf_start, 1, gBUFSIZE, gIN );
+#endif
+	}
+	gbuf = gbuf_start;
+	/* at end of file, get_nbits() keeps reading the same byte, not past it. */
+	gbuf_end = (unsigned char *) (gbuf + (nfread ? nfread : 1));
+}
+
+/* writes the first n bytes of the put buffer to pOUT (or memory). */
+static void write_bytes( unsigned int n )
+{
+	if ( p_mem ) put_memory( n );
+	else {
+#ifdef GT_ASYNC_IO
+		put_ring( n );
+#else
+		fwrite( pbuf_start, n, 1, pOUT );
+#endif
+	}
+}
+
+/* writes out the full put buffer and starts over. */
+void write_put_buffer( void )
+{
+	nbytes_out += pBUFSIZE;
+	write_bytes( pBUFSIZE );
+	pbuf_count = 0;
+	pbuf = pbuf_start;
 }
 
 void flush_put_buffer( void )
 {
+	unsigned int n;
+	
+	if ( p_cnt ) *pbuf = p_byte;  /* the last partial byte. */
 	if ( pbuf_count || p_cnt ) {
-		fwrite( pbuf_start, pbuf_count+(p_cnt?1:0), 1, pOUT );
-		nbytes_out += (pbuf_count+(p_cnt?1:0));
-		pbuf = pbuf_start; pbuf_count = 0; p_cnt = 0;
-		memset( pbuf, 0, pBUFSIZE );
+		n = pbuf_count+(p_cnt?1:0);
+		nbytes_out += n;
+		write_bytes( n );
+		pbuf = pbuf_start; pbuf_count = 0; p_cnt = 0; p_byte = 0;
 	}
+#ifdef GT_ASYNC_IO
+	/* wait until everything is written. */
+	if ( p_ring.uring ) uring_drain( &p_ring );
+	else if ( p_ring.buf[0] ) {
+		pthread_mutex_lock( &p_ring.lock );
+		while ( p_ring.count ) pthread_cond_wait( &p_ring.cond, &p_ring.lock );
+		pthread_mutex_unlock( &p_ring.lock );
+	}
+#endif
 }
 
 static inline int get_bit( void )
@@ -106,11 +599,7 @@ static inline int get_bit( void )
 		if ( g_cnt == 8 ) { /* finished 8 bits? */
 			g_cnt = 0;        /* reset to zero. */
 			if ( (++gbuf) == gbuf_end ) { /* end of buffer? */
-				nbytes_read += nfread;
-				/* then fill buffer again. */
-				gbuf = gbuf_start;
-				nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-				gbuf_end = (unsigned char *) (gbuf + nfread);
+				fill_get_buffer();
 			}
 		}
 	}
@@ -149,10 +638,7 @@ static inline int gfgetc( void )
 	if ( nfread ){
 		c = (int) (*gbuf++);
 		if ( gbuf == gbuf_end ) {
-			nbytes_read += nfread;
-			gbuf = gbuf_start;
-			nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-			gbuf_end = (unsigned char *) (gbuf + nfread);
+			fill_get_buffer();
 		}
 		return c;
 	}
@@ -164,11 +650,25 @@ static inline void pfputc( int c )
 {
 	*pbuf++ = (unsigned char) c;
 	if ( (++pbuf_count) == pBUFSIZE ){
-		fwrite( pbuf_start, pBUFSIZE, 1, pOUT );
-		nbytes_out += pBUFSIZE;
-		pbuf_count = 0;
-		pbuf = pbuf_start;
-		memset( pbuf, 0, pBUFSIZE );
+		write_put_buffer();
+	}
+}
+
+/* Puts n bytes into the output buffer; as pfputc(), at a byte boundary. */
+static inline void pfwrite( unsigned char *s, unsigned int n )
+{
+	unsigned int k;
+	
+	while ( n ) {
+		k = pBUFSIZE - pbuf_count;
+		if ( k > n ) k = n;
+		memcpy( pbuf, s, k );
+		pbuf += k;
+		s += k;
+		n -= k;
+		if ( (pbuf_count += k) == pBUFSIZE ){
+			write_put_buffer();
+		}
 	}
 }
 
@@ -184,11 +684,7 @@ static inline unsigned int get_nbits( int size )
 		in_cnt += (8-g_cnt);
 		g_cnt = 0;
 		if ( (++gbuf) == gbuf_end ) { /* end of buffer? */
-			nbytes_read += nfread;
-			/* then fill buffer again. */
-			gbuf = gbuf_start;
-			nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-			gbuf_end = (unsigned char *) (gbuf + nfread);
+			fill_get_buffer();
 		}
 		
 		if ( size ) do {
@@ -197,10 +693,7 @@ static inline unsigned int get_nbits( int size )
 				size -= 8;
 				in_cnt += 8;
 				if ( (++gbuf) == gbuf_end ) {
-					nbytes_read += nfread;
-					gbuf = gbuf_start;
-					nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-					gbuf_end = (unsigned char *) (gbuf + nfread);
+					fill_get_buffer();
 				}
 			}
 			else break;
@@ -217,36 +710,28 @@ static inline void put_nbits( unsigned int k, int size )
 {
 	k = (k << (INT_BIT-size)) >> (INT_BIT-size);
 	
-	*pbuf |= (k<<(p_cnt));
+	p_byte |= (k<<(p_cnt));
 	if ( size >= (8-p_cnt) ) { /* past one byte? */
 		size -= (8-p_cnt);
 		k >>= (8-p_cnt);
 		p_cnt = 0;
+		*pbuf = p_byte;
 		if ( (++pbuf_count) == pBUFSIZE ){
-			fwrite( pbuf_start, pBUFSIZE, 1, pOUT );
-			nbytes_out += pBUFSIZE;
-			pbuf_count = 0;
-			pbuf = pbuf_start;
-			memset( pbuf, 0, pBUFSIZE );
+			write_put_buffer();
 		}
 		else pbuf++;
 		
-		if ( size ) do {
-			*pbuf |= k;
-			if ( size >= 8 ) { /* past one byte? */
-				size -= 8;
-				k >>= 8;
-				if ( (++pbuf_count) == pBUFSIZE ){
-					fwrite( pbuf_start, pBUFSIZE, 1, pOUT );
-					nbytes_out += pBUFSIZE;
-					pbuf_count = 0;
-					pbuf = pbuf_start;
-					memset( pbuf, 0, pBUFSIZE );
-				}
-				else pbuf++;
+		/* whole bytes are assigned directly. */
+		while ( size >= 8 ) {
+			*pbuf = (unsigned char) k;
+			size -= 8;
+			k >>= 8;
+			if ( (++pbuf_count) == pBUFSIZE ){
+				write_put_buffer();
 			}
-			else break;
-		} while ( size );
+			else pbuf++;
+		}
+		p_byte = (unsigned char) k;
 	}
 	p_cnt += size;
 }
@@ -267,10 +752,7 @@ static inline int get_symbol( int size )
 		in_cnt += (8-g_cnt);
 		g_cnt = 0;
 		if ( (++gbuf) == gbuf_end ) { /* end of buffer? */
-			nbytes_read += nfread;
-			gbuf = gbuf_start;
-			nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-			gbuf_end = (unsigned char *) (gbuf + nfread);
+			fill_get_buffer();
 			/* we still have some bits to read but no more bits
 				from the file; return end-of-file.
 			*/
@@ -288,10 +770,7 @@ static inline int get_symbol( int size )
 				size -= 8;
 				in_cnt += 8;
 				if ( (++gbuf) == gbuf_end ) {
-					nbytes_read += nfread;
-					gbuf = gbuf_start;
-					nfread = fread ( gbuf, 1, gBUFSIZE, gIN );
-					gbuf_end = (unsigned char *) (gbuf + nfread);
+					fill_get_buffer();
 					if ( size > 0 && nfread == 0 ) {
 						/* store the actual bits read. */
 						nbits_read = (k << (INT_BIT-in_cnt)) >> (INT_BIT-in_cnt);
@@ -1,13 +1,28 @@
-/* GTBITIO3.H, Ver. 3, 8/22/2022, 6/27/2023 */
+/* GTBITIO3.H, Ver. 3, 8/22/2022, 6/27/2023, 10/16/2026 */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>  /* C99 */
+#include "gttls.h"
 
 #if !defined( GTBITIO3_H )
 	#define GTBITIO3_H
 
+/* supersedes gtbitio2.h; keeps huf2.c and adhfgk2.c on these macros. */
+#define GTBITIO2_H
+
+/* define GT_ASYNC_IO for the reader and writer threads. */
+#ifdef GT_ASYNC_IO
+	#include <pthread.h>
+	#if !defined( GT_NBUFS )
+		#define GT_NBUFS  3   /* buffers per direction, >= 2. */
+	#endif
+#endif
+
+/* the largest piece of memory a get or put buffer spans. */
+#define GT_MEM_CHUNK  (1U<<30)
+
 /* for get_nbits() and put_nbits().
 
 INT_BIT is the number of bits in an 
@@ -26,7 +41,9 @@ number of bits.
 	#endif
 #endif
 
-#define pset_bit() *pbuf |= (1<<p_cnt)
+/* bits are collected in p_byte and the whole byte is then
+assigned to *pbuf, so the output buffer needs no clearing. */
+#define pset_bit() p_byte |= (1<<p_cnt)
 
 /* ---- writes a ONE (1) bit. ---- */
 #define put_ONE() { pset_bit(); advance_buf(); }
@@ -39,12 +56,10 @@ number of bits.
 {                          \
 	if ( (++p_cnt) == 8 ) { \
 		p_cnt = 0; \
+		*pbuf = p_byte; \
+		p_byte = 0; \
 		if ( (++pbuf_count) == pBUFSIZE ){ \
-			pbuf = pbuf_start; \
-			fwrite( pbuf, pBUFSIZE, 1, pOUT ); \
-			memset( pbuf, 0, pBUFSIZE ); \
-			pbuf_count = 0; \
-			nbytes_out += pBUFSIZE; \
+			write_put_buffer(); \
 		} \
 		else pbuf++; \
 	} \
@@ -56,21 +71,19 @@ number of bits.
 	if ( (++g_cnt) == 8 ){   \
 		g_cnt = 0;   \
 		if ( ++gbuf == gbuf_end ) {   \
-			nbytes_read += nfread;   \
-			gbuf = gbuf_start;   \
-			nfread = fread ( gbuf, 1, gBUFSIZE, gIN );   \
-			gbuf_end = (unsigned char *) (gbuf + nfread);   \
+			fill_get_buffer();   \
 		}   \
 	}   \
 }
 
-extern FILE *gIN, *pOUT;
-extern unsigned int pBUFSIZE, gBUFSIZE;
-extern unsigned char *pbuf, *pbuf_start, p_cnt;
-extern unsigned char *gbuf, *gbuf_start, *gbuf_end, g_cnt;
-extern unsigned int bit_read, nbits_read;
-extern unsigned int pbuf_count, nfread;
-extern int64_t nbytes_out, nbytes_read;
+extern GT_TLS FILE *gIN, *pOUT;
+extern GT_TLS unsigned int pBUFSIZE, gBUFSIZE;
+extern GT_TLS unsigned char *pbuf, *pbuf_start, p_cnt, p_byte;
+extern GT_TLS unsigned char *gbuf, *gbuf_start, *gbuf_end, g_cnt;
+extern GT_TLS unsigned int bit_read, nbits_read;
+extern GT_TLS unsigned int pbuf_count, nfread;
+extern GT_TLS int64_t nbytes_out, nbytes_read;
+extern GT_TLS int p_mem_full;
 
 void init_buffer_sizes( unsigned int size );
 void init_put_buffer( void );
@@ -78,9 +91,15 @@ void init_get_buffer( void );
 void free_put_buffer( void );
 void free_get_buffer( void );
 void flush_put_buffer( void );
+void fill_get_buffer( void );
+void write_put_buffer( void );
+void init_get_memory( unsigned char *p, size_t n );
+void init_put_memory( unsigned char *p, size_t n );
+void free_memory_io( void );
 static inline int  get_bit( void );
 static inline int  gfgetc( void );
 static inline void pfputc( int c );
+static inline void pfwrite( unsigned char *s, unsigned int n );
 static inline unsigned int get_nbits( int size );
 static inline void put_nbits( unsigned int k, int size );
 static inline int get_symbol( int size );
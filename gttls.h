@@ -0,0 +1,32 @@
+/*
+	Filename:   GTTLS.H
+	Author:     Gerald Tamayo
+	Date:       10/16/2026
+	
+	The storage class of the codec modules' state (gtbitio3,
+	lzhash2, mtf, huf2/adhuf1, lzhhf5). With GT_REENTRANT defined,
+	each thread has its own copy, so threads can run a codec each.
+	
+	This is a codec per thread, not a context per instance: a
+	thread runs one coder or decoder at a time, and the FGK tree
+	points into its own copy, so a codec can't be handed to
+	another thread or set aside for another. Code that needs many
+	codecs open at once runs each one to the end within a call
+	(lzuf.c: blocks, with nothing kept between calls).
+*/
+#if !defined( GTTLS_H )
+	#define GTTLS_H
+
+#if defined( GT_REENTRANT )
+	#if defined( _MSC_VER )
+		#define GT_TLS  __declspec(thread)
+	#elif defined( __STDC_VERSION__ ) && __STDC_VERSION__ >= 201112L && !defined( __STDC_NO_THREADS__ )
+		#define GT_TLS  _Thread_local
+	#else
+		#define GT_TLS  __thread
+	#endif
+#else
+	#define GT_TLS
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/*
+	Filename:   GTURING.C
+	Author:     Gerald Tamayo
+	Date:       10/16/2026
+	
+	A minimal io_uring interface (Linux 5.6+) for the buffer rings
+	of gtbitio3.c: reads and writes at file offsets are queued
+	without waiting, and completions are reaped one at a time.
+	
+	The buffers are registered with the kernel when possible, so
+	the READ_FIXED/WRITE_FIXED opcodes skip the per-I/O page
+	mapping; otherwise plain READ/WRITE is used.
+	
+	If io_uring_enter fails (other than EINTR/EAGAIN), the ring is
+	marked failed and the caller does the rest with pread/pwrite.
+	
+	Uses the raw system calls; liburing is not needed.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include "gturing.h"
+
+/* returns 0 if the kernel won't set up a ring. */
+int gt_uring_init( gt_uring_t *u, unsigned entries,
+	unsigned char **bufs, int nbufs, unsigned size )
+{
+	struct io_uring_params p;
+	struct iovec *iov;
+	unsigned char *sq, *cq;
+	int i;
+	
+	memset( u, 0, sizeof(gt_uring_t) );
+	memset( &p, 0, sizeof(p) );
+	u->fd = (int) syscall( __NR_io_uring_setup, entries, &p );
+	if ( u->fd < 0 ) return 0;
+	
+	u->sq_sz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	u->cq_sz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	u->sqes_sz = p.sq_entries * sizeof(struct io_uring_sqe);
+	u->sq_ptr = mmap( NULL, u->sq_sz, PROT_READ|PROT_WRITE,
+		MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQ_RING );
+	u->cq_ptr = mmap( NULL, u->cq_sz, PROT_READ|PROT_WRITE,
+		MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_CQ_RING );
+	u->sqes = (struct io_uring_sqe *) mmap( NULL, u->sqes_sz, PROT_READ|PROT_WRITE,
+		MAP_SHARED|MAP_POPULATE, u->fd, IORING_OFF_SQES );
+	if ( u->sq_ptr == MAP_FAILED || u->cq_ptr == MAP_FAILED
+			|| (void *) u->sqes == MAP_FAILED ) {
+		gt_uring_free( u );
+		return 0;
+	}
+	sq = (unsigned char *) u->sq_ptr;
+	u->sq_head  = (unsigned *) (sq + p.sq_off.head);
+	u->sq_tail  = (unsigned *) (sq + p.sq_off.tail);
+	u->sq_mask  = (unsigned *) (sq + p.sq_off.ring_mask);
+	u->sq_array = (unsigned *) (sq + p.sq_off.array);
+	cq = (unsigned char *) u->cq_ptr;
+	u->cq_head  = (unsigned *) (cq + p.cq_off.head);
+	u->cq_tail  = (unsigned *) (cq + p.cq_off.tail);
+	u->cq_mask  = (unsigned *) (cq + p.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+	
+	/* register the buffers; may fail under a low RLIMIT_MEMLOCK. */
+	iov = (struct iovec *) malloc( sizeof(struct iovec) * nbufs );
+	if ( iov ) {
+		for ( i = 0; i < nbufs; i++ ) {
+			iov[i].iov_base = bufs[i];
+			iov[i].iov_len = size;
+		}
+		u->fixed = syscall( __NR_io_uring_register, u->fd,
+			IORING_REGISTER_BUFFERS, iov, nbufs ) == 0;
+		free( iov );
+	}
+	return 1;
+}
+
+void gt_uring_free( gt_uring_t *u )
+{
+	if ( u->sq_ptr && u->sq_ptr != MAP_FAILED ) munmap( u->sq_ptr, u->sq_sz );
+	if ( u->cq_ptr && u->cq_ptr != MAP_FAILED ) munmap( u->cq_ptr, u->cq_sz );
+	if ( u->sqes && (void *) u->sqes != MAP_FAILED ) munmap( u->sqes, u->sqes_sz );
+	if ( u->fd >= 0 ) close( u->fd );
+	memset( u, 0, sizeof(gt_uring_t) );
+	u->fd = -1;
+}
+
+/*
+Queues a read (or a write) of buffer idx at offset off. Returns 0,
+with nothing queued, if the kernel won't take it; the caller then
+does the I/O itself.
+*/
+int gt_uring_submit( gt_uring_t *u, int write, int fd, int idx,
+	unsigned char *buf, unsigned len, int64_t off )
+{
+	unsigned tail = *u->sq_tail, i = tail & *u->sq_mask;
+	struct io_uring_sqe *sqe = &u->sqes[i];
+	
+	if ( u->failed ) return 0;
+	memset( sqe, 0, sizeof(struct io_uring_sqe) );
+	if ( u->fixed ) {
+		sqe->opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+		sqe->buf_index = idx;
+	}
+	else sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t) (uintptr_t) buf;
+	sqe->len = len;
+	sqe->off = (uint64_t) off;
+	sqe->user_data = idx;
+	u->sq_array[i] = i;
+	__atomic_store_n( u->sq_tail, tail+1, __ATOMIC_RELEASE );
+	while ( syscall( __NR_io_uring_enter, u->fd, 1, 0, 0, NULL, 0 ) < 0 ) {
+		if ( errno == EINTR || errno == EAGAIN ) continue;
+		u->failed = 1;
+		if ( __atomic_load_n( u->sq_head, __ATOMIC_ACQUIRE ) == tail ) {
+			*u->sq_tail = tail;  /* not consumed; take it back. */
+			return 0;
+		}
+		break;  /* queued anyway. */
+	}
+	return 1;
+}
+
+/*
+Waits for a completion; returns its buffer index, and the byte
+count (or -errno) in *res. Returns -1 if the ring has failed: the
+I/O still pending must be done by the caller.
+*/
+int gt_uring_wait( gt_uring_t *u, int *res )
+{
+	unsigned head = *u->cq_head;
+	struct io_uring_cqe *cqe;
+	int idx;
+	
+	while ( head == __atomic_load_n( u->cq_tail, __ATOMIC_ACQUIRE ) ) {
+		if ( u->failed ) return -1;
+		if ( syscall( __NR_io_uring_enter, u->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0 ) < 0
+			&& errno != EINTR && errno != EAGAIN ) u->failed = 1;
+	}
+	cqe = &u->cqes[ head & *u->cq_mask ];
+	idx = (int) cqe->user_data;
+	*res = cqe->res;
+	__atomic_store_n( u->cq_head, head+1, __ATOMIC_RELEASE );
+	return idx;
+}
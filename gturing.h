@@ -0,0 +1,35 @@
+/*
+	Filename:   GTURING.H
+	Author:     Gerald Tamayo
+	Date:       10/16/2026
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <linux/io_uring.h>
+
+#if !defined( GTURING_H )
+	#define GTURING_H
+
+/* an io_uring instance: the submission and completion queues. */
+typedef struct {
+	int fd;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ptr, *cq_ptr;
+	size_t sq_sz, cq_sz, sqes_sz;
+	int fixed;   /* the buffers are registered. */
+	int failed;  /* io_uring_enter failed; use pread/pwrite. */
+} gt_uring_t;
+
+/* ---- function prototypes. ---- */
+int gt_uring_init( gt_uring_t *u, unsigned entries,
+	unsigned char **bufs, int nbufs, unsigned size );
+void gt_uring_free( gt_uring_t *u );
+int gt_uring_submit( gt_uring_t *u, int write, int fd, int idx,
+	unsigned char *buf, unsigned len, int64_t off );
+int gt_uring_wait( gt_uring_t *u, int *res );
+
+#endif
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "gttls.h"
 
 #ifndef HUF_H
 	#define HUF_H
@@ -27,26 +28,26 @@ typedef struct{
 	unsigned long f;
 } hfreq_type;
 
-extern unsigned int hcount;
-extern hfreq_type hfreq[];
+extern GT_TLS unsigned int hcount;
+extern GT_TLS hfreq_type hfreq[];
 
-extern listnode_t *list,    /* the list (current) pointer  */
+extern GT_TLS listnode_t *list,    /* the list (current) pointer  */
 	*top,                   /* the top of the Huffman tree */
 	*list_head;             /* the list_head pointer       */
 
 /* this is the list of symbol addresses in the binary/Huffman tree .*/
-extern listp hufflist[];
+extern GT_TLS listp hufflist[];
 
-extern listnode_t hnodes[];
-extern unsigned int hn;
+extern GT_TLS listnode_t hnodes[];
+extern GT_TLS unsigned int hn;
 
 /*
 the following are conveniently used
 by the adaptive Huffman functions
 */
-extern unsigned hmax_symbols;
-extern int hmin;
-extern unsigned int hsymbol_bit_size;
+extern GT_TLS unsigned hmax_symbols;
+extern GT_TLS int hmin;
+extern GT_TLS unsigned int hsymbol_bit_size;
 
 /* forward declarations */
 listnode_t *create_node( void );
@@ -72,7 +73,7 @@ typedef struct code {
 	unsigned char bit[H_MAX/8];	/* 32 bytes. */
 }	code_table_t;
 
-extern code_table_t hcode_table[ ];
+extern GT_TLS code_table_t hcode_table[ ];
 
 /* function declarations */
 void get_hcode ( listnode_t *node );
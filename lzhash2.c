@@ -7,23 +7,27 @@
 	a hash table of "doubly-linked" lists.
 
     *hashp added to record hash of position (i) and faster delete_lznode() calls. (2/4/2023)
+    delete_lznode() resets hashp[i] to LZ_NULL, so a position may be left unlisted. (10/16/2026)
+    free_lzhash() leaves the table pointers NULL, for another alloc_lzhash(). (10/16/2026)
+    The tables are GT_TLS (gttls.h), per thread with GT_REENTRANT. (10/16/2026)
+    reset_lzhash() empties the tables for reuse, without freeing them. (10/17/2026)
 */
 #include <stdio.h>
 #include <stdlib.h>
 #include "lzhash2.h"
 
 /* stores the hashes of positions i */
-int *hashp = NULL;
+GT_TLS int *hashp = NULL;
 
 /* this is the *hash table* of listheads. */
-int *lzhash = NULL;
+GT_TLS int *lzhash = NULL;
 
 /*
 	these arrays contain the "previous" and "next" pointers
 	of the virtual nodes.
 */
-int *lzprev = NULL;
-int *lznext = NULL;
+GT_TLS int *lzprev = NULL;
+GT_TLS int *lznext = NULL;
 
 /*
 	allocate memory to the hash table and linked-list tables.
@@ -68,6 +72,21 @@ void free_lzhash( void )
 	if ( lzprev ) free( lzprev );
 	if ( lznext ) free( lznext );
 	if ( hashp ) free( hashp );
+	lzhash = lzprev = lznext = hashp = NULL;
+}
+
+/*
+	empties the first size lists of the tables, for a new window;
+	the prev and next pointers are set when a node is inserted.
+*/
+void reset_lzhash( int size )
+{
+	int i;
+	
+	for ( i = 0; i < size; i++ ){
+		lzhash[i] = LZ_NULL;
+		hashp[i] = LZ_NULL;
+	}
 }
 
 /* ---- inserts a node (position i) into the hash list lzhash[h] ---- */
@@ -88,6 +107,8 @@ void insert_lznode( int h, int i )
 /* ---- deletes an LZ node (position i) ---- */
 void delete_lznode( int h, int i )
 {
+	hashp[i] = LZ_NULL;  /* position i is no longer listed. */
+	
 	if ( lzhash[h] == i ) { /* the head of the list? */
 		/* the next node becomes the head of the list */
 		lzhash[h] = lznext[i];
@@ -5,20 +5,22 @@
 */
 #include <stdio.h>
 #include <stdlib.h>
+#include "gttls.h"
 
 #if !defined(LZHASH_H)
 	#define LZHASH_H
 
 #define LZ_NULL  -1
 
-extern int *hashp;
-extern int *lzhash;
-extern int *lzprev;
-extern int *lznext;
+extern GT_TLS int *hashp;
+extern GT_TLS int *lzhash;
+extern GT_TLS int *lzprev;
+extern GT_TLS int *lznext;
 
 /* ---- function prototypes. ---- */
 int alloc_lzhash( int size );
 void free_lzhash( void );
+void reset_lzhash( int size );
 void insert_lznode( int h, int i );
 void delete_lznode( int h, int i );
 
@@ -10,6 +10,8 @@
 		(7/23/2023) Single file coder/decoder.
 		(12/13/2023) Fast decode function.
 		(3/27/2024) Just a little faster coder function.
+		(10/16/2026) Decoder moves strings in the window with memmove(), through pattern[] only
+		             where they wrap around its end, and writes them out whole (pfwrite()).
 */
 #include <stdio.h>
 #include <stdlib.h>
@@ -85,6 +87,7 @@ void compress( unsigned char *w, unsigned char *p );
 void decompress( unsigned char *w, unsigned char *p );
 static inline void search( unsigned char *w, unsigned char *p );
 static inline void put_codes( unsigned char *w, unsigned char *p );
+static inline unsigned char *copy_window( unsigned char *w, unsigned char *s, unsigned int pos, unsigned int len );
 
 void usage( void )
 {
@@ -319,7 +322,7 @@ void compress( unsigned char *w, unsigned char *p )
 
 void decompress( unsigned char *w, unsigned char *p )
 {
-	int i, k;
+	int k;
 	int64_t fsize;
 	
 	fsize = fstamp.file_size;
@@ -336,17 +339,8 @@ void decompress( unsigned char *w, unsigned char *p )
 			dpos.pos = (k << hash_SHIFT) | get_nbits( hash_SHIFT );
 			dpos.len = len_CODE + (MIN_LEN+1);  /* actual length. */
 			
-			/* if its a match, then "slide" the window buffer. */
-			i = dpos.len;
-			while ( i-- ) {
-				/* copy byte. */
-				p[i] = w[ (dpos.pos+i) & win_MASK ];
-			}
-			i = 0;
-			while ( i < dpos.len ) {
-				w[ (win_cnt+i) & win_MASK ] = p[i];  /* update window */
-				pfputc( p[i++] );  /* output byte. */
-			}
+			/* if its a match, then "slide" the window buffer, and output the string. */
+			pfwrite( copy_window( w, p, dpos.pos, dpos.len ), dpos.len );
 			fsize -= dpos.len;
 			win_cnt = (win_cnt + dpos.len) & win_MASK;
 		}
@@ -369,17 +363,8 @@ void decompress( unsigned char *w, unsigned char *p )
 			dpos.pos = (k << hash_SHIFT) | get_nbits( hash_SHIFT );
 			dpos.len = MIN_LEN;
 			
-			/* if its a match, then "slide" the window buffer. */
-			i = dpos.len;
-			while ( i-- ) {
-				/* copy byte. */
-				p[i] = w[ (dpos.pos+i) & win_MASK ];
-			}
-			i = 0;
-			while ( i < dpos.len ) {
-				w[ (win_cnt+i) & win_MASK ] = p[i];  /* update window */
-				pfputc( p[i++] );  /* output byte. */
-			}
+			/* if its a match, then "slide" the window buffer, and output the string. */
+			pfwrite( copy_window( w, p, dpos.pos, dpos.len ), dpos.len );
 			fsize -= dpos.len;
 			win_cnt = (win_cnt + dpos.len) & win_MASK;
 			
@@ -389,6 +374,36 @@ void decompress( unsigned char *w, unsigned char *p )
 	}
 }
 
+/*
+Copies the len-byte string (len <= win_BUFSIZE) at window position
+pos to win_cnt, with the bytes the window had before the copy, and
+returns where the string now is in one piece. If neither the string
+nor its copy wraps around the end of the ring, it is moved in place
+with memmove() (wide, and with the same result where the two
+overlap); else it goes through s, in two parts where it wraps.
+*/
+static inline unsigned char *copy_window( unsigned char *w, unsigned char *s, unsigned int pos, unsigned int len )
+{
+	unsigned int n = win_BUFSIZE - pos;
+	
+	if ( len <= n && len <= win_BUFSIZE - win_cnt ) {
+		memmove( w+win_cnt, w+pos, len );
+		return w+win_cnt;
+	}
+	if ( len <= n ) memcpy( s, w+pos, len );
+	else {
+		memcpy( s, w+pos, n );
+		memcpy( s+n, w, len-n );
+	}
+	n = win_BUFSIZE - win_cnt;
+	if ( len <= n ) memcpy( w+win_cnt, s, len );
+	else {
+		memcpy( w+win_cnt, s, n );
+		memcpy( w, s+n, len-n );
+	}
+	return s;
+}
+
 /*
 This function searches the sliding window buffer for the largest
 "string" stored in the pattern buffer.
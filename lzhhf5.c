@@ -0,0 +1,2683 @@
+/*
+	---- A Lempel-Ziv Unary (LZUF) + Adaptive Huffman Coding Implementation ----
+
+	Filename:      lzhhf5.c
+	Written by:    Gerald Tamayo, Oct. 22, 2008 (2/24/2022)
+	
+	Version 2:
+		(2/27/2022) Optional bit size for sliding window implemented, BITS = 12..20, default = 17.
+		(7/07/2023) Optional bitsize of "hash bucket" search list, BITS = 1..12, default = 9.
+		(7/23/2023) Single file coder/decoder.
+		(12/13/2023) Fast decode function.
+		(3/27/2024) Just a little faster coder function.
+	
+	Version 3:
+		(10/16/2026) Adaptive Golomb-Rice match lengths with an Exp-Golomb escape (file stamp "LZUF5").
+		(10/16/2026) Match distances as log2 slots (FGK) + extra bits; a distance may be shorter than the length.
+		(10/16/2026) Repeat-distance codes for the NUM_REPS most recent match distances.
+		(10/16/2026) Literal runs: one run length, then the run's bytes; fewer searches on incompressible data.
+		(10/16/2026) The coder searches a linear view of the input: the mmap'd file, or a sliding
+		             buffer for pipes. No window or pattern copies; same output either way.
+		(10/16/2026) The decoder writes into the mmap'd output file (or a chunk buffer for pipes)
+		             and copies strings from the output itself; no win_buf, no pfputc().
+		(10/16/2026) Strings are copied COPY_STEP bytes a step, or by doubling the period if shorter.
+		(10/16/2026) gtbitio3 reads and writes on its own threads (GT_ASYNC_IO; link with -lpthread).
+		(10/16/2026) On Linux, regular files go through io_uring instead (GT_URING, gturing.c).
+		(10/16/2026) Streaming mode (-s, or any output that can't be rewound): the data ends with an
+		             end-of-stream code instead of a size in the file stamp; -t adds a trailer with
+		             the size and CRC-32 of the data. "-" names stdin or stdout.
+		(10/16/2026) With LZUF_LIB defined there is no main(); lzuf.c runs the coder and decoder
+		             in memory. Its incompressible data is stored as is (LZUF_STORED).
+		(10/16/2026) All state is GT_TLS (gttls.h); with GT_REENTRANT each thread has its own codec.
+		(10/16/2026) The input and output views read from g_source and write to p_sink when set
+		             (the lzuf.c streams).
+		(10/16/2026) Flush points in a stream (SYNC_FLUSH): the coder pads to a byte and writes out
+		             all of its output so far, and the decoder all of the data so far; the window
+		             and the models are kept.
+		(10/16/2026) -T[N]: independent blocks (-bM MB each) coded on N threads, in a framed
+		             container (LZUF_BLOCKS). Its blocks are also decoded on N threads (-d).
+		(10/16/2026) -p: each -T block is primed with the window of input before it (LZUF_PRIMED);
+		             its coding stays parallel, its decoding is in order.
+		(10/16/2026) With two or more processors, one thread parses the input (the search and the
+		             hash lists) and hands batches of tokens to the coder on another; same output.
+		(10/16/2026) -m[K]: one stream whose input (if mapped) is parsed in 1 MB ranges on K threads,
+		             each primed with the window before it; the tokens are coded in order.
+		(10/16/2026) -l: a list of files (or a directory) coded through one -T ring into an archive
+		             of -T streams (LZUF_ARCHIVE), each with a window fitted to its file; -d extracts it.
+		(10/16/2026) -v: codes the input of -T, -m or -l again on one thread and compares the output.
+		(10/16/2026) -n: the workers pinned to processors, one NUMA node after another; each codes
+		             its blocks from a copy on its own node (Linux).
+		(10/16/2026) -T files (without -p) end with a block index (LZUF_INDEXED); -d -rFROM,LEN
+		             decodes only the blocks that hold those bytes (lzuf_decompress_range()).
+		(10/17/2026) The lzuf.c streams code whole -T -p blocks; g_source, p_sink and the coder's
+		             flush points are gone (the decoder still takes SYNC_FLUSH).
+		(10/17/2026) The -T, -m and -l workers set up their MTF list and hash lists once, and
+		             only reset them between blocks.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+#if defined(_WIN32)
+	#include <io.h>
+	#include <fcntl.h>
+	#include <direct.h>
+	#define make_dir(d)  _mkdir(d)
+	#define file_seek(f,o,w)  _fseeki64( f, o, w )
+	#define file_tell(f)  _ftelli64( f )
+#endif
+#if defined(__unix__) || defined(__unix) || defined(__APPLE__)
+	#define LZUF_MMAP
+	#if !defined( LZUF_LIB )
+		#define GT_ASYNC_IO
+		#define GT_REENTRANT   /* -T: a codec on each thread. */
+		#define LZUF_THREADS
+		#include <pthread.h>
+		#if defined(__linux__) && defined(__has_include)
+			#if __has_include(<linux/io_uring.h>)
+				#define GT_URING
+			#endif
+		#endif
+		#if defined(__linux__)
+			#include <sys/syscall.h>
+			#define LZUF_PIN   /* -n: sched_setaffinity(). */
+		#endif
+	#endif
+	#include <sys/types.h>
+	#include <sys/stat.h>
+	#include <sys/mman.h>
+	#include <unistd.h>
+	#include <dirent.h>
+	#define LZUF_DIRS
+	#if !defined(__APPLE__)
+		#include <fcntl.h>
+		#define LZUF_RESERVE   /* posix_fallocate(): -d maps its output only with the space reserved. */
+	#endif
+	#define make_dir(d)  mkdir( d, 0777 )
+	#define file_seek(f,o,w)  fseeko( f, (off_t) (o), w )
+	#define file_tell(f)  ((int64_t) ftello( f ))
+#endif
+#if !defined( make_dir )
+	#define make_dir(d)  ((void) (d))   /* -d of an archive: its directories must be there. */
+#endif
+#if !defined( file_seek )
+	#define file_seek(f,o,w)  fseek( f, (long) (o), w )
+	#define file_tell(f)  ((int64_t) ftell( f ))
+#endif
+#include "utypes.h"
+#include "gttls.h"
+#include "gtbitio3.c"
+#include "ucodes3.c"
+#include "lzhash2.c"
+#include "mtf.c"
+#include "huf2.c"
+#include "adhfgk2.c"
+
+enum {
+	/* modes */
+	COMPRESS,
+	DECOMPRESS
+};
+
+/* the decompressor's must also equal these values. */
+#define LTCB              17              /* 12..20 tested working */
+#ifdef LTCB 
+    #define NUM_POS_BITS LTCB
+#else 
+    #define NUM_POS_BITS  15
+#endif
+
+#define MIN_LEN           4               /* minimum string size >= 2 */
+#define MTF_SIZE        256
+#define FAR_LIST_BITS     9
+
+#define HASH_BYTES_N      4
+
+/* adaptive length codes. */
+#define LEN_ESC_Q        12     /* unary quotient that escapes to Exp-Golomb. */
+#define LEN_MAX_K        16     /* maximum Golomb-Rice parameter. */
+#define LEN_RESET        64     /* halve the length statistics every LEN_RESET codes. */
+
+/* literal runs. */
+#define LIT_RUN_MAX    4096     /* longest literal run sent at once. */
+#define LIT_SKIP_SHIFT    5     /* search only every (misses >> LIT_SKIP_SHIFT)+1 bytes, */
+#define LIT_SKIP_MAX     16     /* up to every LIT_SKIP_MAX+1 bytes. */
+
+#define OUT_CHUNK   (1<<20)     /* decoder output written at a time (not mapped). */
+#define COPY_STEP        16     /* bytes per step of a string copy. */
+
+/* repeat distances. */
+#define NUM_REPS          4     /* the recent distances kept; FGK symbols 0..NUM_REPS-1. */
+#define REP_GOOD_LEN     32     /* a repeat match this long skips the hash search. */
+
+/* file stamp flags. */
+#define LZUF_STREAM       1     /* ends with END_OF_STREAM; no file_size. */
+#define LZUF_TRAILER      2     /* the size and CRC-32 follow END_OF_STREAM. */
+#define LZUF_STORED       4     /* the data as is, not coded. */
+#define LZUF_BLOCKS       8     /* frames of independent blocks (-T). */
+#define LZUF_PRIMED      16     /* each block primed with the window before it (-p). */
+#define LZUF_ARCHIVE     32     /* the -T streams of several files, with their names (-l). */
+#define LZUF_INDEXED     64     /* a block index after the end frame (-T without -p). */
+
+/* -T blocks. */
+#define BLOCK_MB          8     /* MB per block, default. */
+#define BLOCK_MAX   (1<<30)     /* the largest block a decoder takes. */
+#define NAME_MAX_LEN   4096     /* the longest file name in an archive. */
+#define INDEX_ENTRY      24     /* bytes per block in the index; */
+#define INDEX_FOOTER     16     /* and after it, the count and INDEX_MAGIC. */
+#define INDEX_MAGIC   "LZUFIDX"
+
+/* a literal run one longer than LIT_RUN_MAX ends a stream; two longer, a flush point. */
+#define END_OF_STREAM  (LIT_RUN_MAX+1)
+#define SYNC_FLUSH     (LIT_RUN_MAX+2)
+
+/* 4-byte hash of the string at q. */
+#define hash(q) \
+	((((q)[0]<<hash_SHIFT) \
+	^((q)[1]<<7) \
+	^((q)[2]<<4) \
+	^((q)[3]))&win_MASK)
+	
+typedef struct {
+	char algorithm[8];
+	int64_t file_size;
+	int num_pos_bits;
+	int flags;   /* was padding; 0 in older files. */
+} file_stamp;
+
+typedef struct {
+	unsigned int pos, len;
+} dpos_t;
+
+/* an adaptive Golomb-Rice code. */
+typedef struct {
+	unsigned int sum, n, k;
+} agolomb_t;
+
+/* a match of len bytes at distance d, or (d = 0) the literal byte len. */
+typedef struct {
+	unsigned int d, len;
+} lz_token;
+
+/* the parser's part of the state, carried to a thread that parses. */
+typedef struct {
+	FILE *in;
+	unsigned char *in_buf;
+	int64_t in_base, in_end, in_cur;
+	unsigned int in_BUFSIZE;
+	int in_mapped, in_eof;
+	unsigned int win_BUFSIZE, win_MASK, hash_SHIFT, pat_BUFSIZE;
+	int far_LIST, flags, win_cnt;
+	unsigned int rep_dist[ NUM_REPS ];
+	uint32_t data_crc;
+	int *lzhash, *lzprev, *lznext, *hashp;
+} parse_state;
+
+GT_TLS unsigned int num_POS_BITS = NUM_POS_BITS; /* default */
+GT_TLS unsigned int win_BUFSIZE  = 1<<NUM_POS_BITS;
+GT_TLS unsigned int win_MASK;
+GT_TLS unsigned int hash_SHIFT;
+GT_TLS unsigned int pat_BUFSIZE;   /* must be a power of 2. */
+GT_TLS int far_LIST_BITS = FAR_LIST_BITS;  /* default */
+GT_TLS int far_LIST = 1<<FAR_LIST_BITS;
+
+GT_TLS dpos_t dpos;
+GT_TLS int win_cnt = 0, buf_cnt = 0;  /* some counters. */
+GT_TLS int len_CODE = 0;     /* the transmitted length code. */
+GT_TLS agolomb_t len_model = { 4, 1, 2 };   /* match lengths. */
+GT_TLS agolomb_t run_model = { 1, 1, 0 };   /* literal run lengths. */
+GT_TLS unsigned char lit_buf[ LIT_RUN_MAX ];  /* the pending literal run. */
+GT_TLS int lit_cnt = 0, lit_miss = 0, lit_skip = 0;
+GT_TLS unsigned int rep_dist[ NUM_REPS ] = { 1, 2, 3, 4 };  /* most recent first. */
+GT_TLS file_stamp fstamp;
+GT_TLS uint32_t crc_table[ 256 ], data_crc = 0;
+GT_TLS int pin_threads = 0;   /* -n */
+GT_TLS int codec_kept = 0;         /* a worker keeps its MTF list from block to block, */
+GT_TLS unsigned int hash_kept = 0; /* and its hash lists, for windows up to this size. */
+
+/*
+The coder's view of its input: the whole file when it can be
+mapped, else a sliding buffer of the last win_BUFSIZE bytes (the
+window) plus at least pat_BUFSIZE+HASH_BYTES_N bytes of look-ahead.
+*/
+GT_TLS unsigned char *in_buf = NULL;
+GT_TLS int64_t in_base = 0;   /* input offset of in_buf[0]. */
+GT_TLS int64_t in_end  = 0;   /* input offset past the last byte in in_buf. */
+GT_TLS int64_t in_cur  = 0;   /* input offset of the current position. */
+GT_TLS unsigned int in_BUFSIZE = 0;
+GT_TLS int in_mapped = 0, in_eof = 0;
+
+/*
+The decoder's output: the whole output file, mapped and written in
+place, else a buffer written out in OUT_CHUNK pieces which keeps the
+last win_BUFSIZE bytes. Either way, the window is the output itself.
+*/
+GT_TLS unsigned char *out_buf = NULL;
+GT_TLS int64_t out_base = 0;   /* output offset of out_buf[0]. */
+GT_TLS int64_t out_cur  = 0;   /* output offset of the next byte. */
+GT_TLS int64_t out_done = 0;   /* output bytes written out so far (not mapped). */
+GT_TLS unsigned int out_BUFSIZE = 0;
+GT_TLS unsigned int out_ROOM = 0;  /* the longest string or literal run. */
+GT_TLS int out_mapped = 0;
+
+void copyright( void );
+int open_input_view( FILE *in );
+void fill_input_view( void );
+void close_input_view( void );
+void compress( void );
+unsigned char *map_output( FILE *out, int64_t size );
+int open_output_view( FILE *out, int64_t size );
+void flush_output_view( void );
+void close_output_view( void );
+int decompress( void );
+void reset_state( void );
+void put_end_of_stream( void );
+int get_end_of_stream( void );
+int init_codec( int bits, int list_bits );
+void free_codec( void );
+static int block_lzhash( void );
+size_t compress_block( const unsigned char *src, size_t n,
+	unsigned char *dst, size_t cap, int bits, int list_bits, size_t prime );
+int decompress_block( const unsigned char *src, size_t cn,
+	unsigned char *dst, size_t n, int bits, size_t prime );
+int compress_blocks( int nthreads, size_t bsize );
+int compress_ranges( int nthreads );
+char **read_names( char *arg, int *nnames, int *skip );
+int compress_files( char **names, int nnames, int skip, int nthreads, size_t bsize );
+int extract_files( char *dir, int nthreads );
+int check_output( char *outname, char **names, int nnames, int skip, size_t bsize );
+int extract_range( int64_t from, int64_t len );
+void save_parser( parse_state *ps );
+void load_parser( parse_state *ps );
+#ifdef LZUF_THREADS
+int compress_pipeline( void );
+#endif
+int decompress_blocks( int nthreads );
+void init_crc32( void );
+uint32_t crc32( uint32_t crc, unsigned char *p, size_t n );
+FILE *open_file( char *name, char *mode );
+static inline void search( unsigned char *p );
+static inline unsigned int parse( unsigned char *p );
+static inline void put_token( unsigned int d, unsigned int len );
+static inline void slide( unsigned char *p );
+static inline void update_reps( unsigned int d );
+static void prime_window( void );
+static void put_le32( unsigned char *p, uint32_t v );
+#if !defined( LZUF_LIB )
+static void put_le64( unsigned char *p, uint64_t v );
+#endif
+static uint32_t get_le32( const unsigned char *p );
+static uint64_t get_le64( const unsigned char *p );
+static int64_t index_blocks( const unsigned char *f, int64_t fsize );
+static int64_t find_block( const unsigned char *index, int64_t nblocks, int64_t pos );
+static inline void put_literals( void );
+static inline void put_agolomb( agolomb_t *m, unsigned int n );
+static inline unsigned int get_agolomb( agolomb_t *m );
+static inline int match_len( unsigned char *p, int d, int k );
+static inline void put_distance( unsigned int d );
+static inline unsigned int get_distance( void );
+static inline void copy_string( unsigned char *o, unsigned int d, unsigned int len, int wild );
+
+#if !defined( LZUF_LIB )
+/* the number of processors online, for -T. */
+static int num_cpus( void )
+{
+#if defined(_SC_NPROCESSORS_ONLN)
+	long n = sysconf( _SC_NPROCESSORS_ONLN );
+	
+	if ( n > 0 ) return n > 256 ? 256 : (int) n;
+#endif
+	return 1;
+}
+
+void usage( void )
+{
+	fprintf(stderr, "\n Usage: lzhhf5 [-c[N]] [-fM] [-s] [-t] [-T[K] [-bB] [-p]] [-m[K]] [-l] [-v] [-n] [-d [-rF,L]] infile outfile\n\n where c = encoding/compression (with adaptive Huffman coding).");
+	fprintf(stderr, "\n       N = nbits size (N = 12..20) of window buffer, default=17;");
+	fprintf(stderr, "\n       M = bitsize of hash bucket search list (M = 1..12) default=9.");
+	fprintf(stderr, "\n       s = streaming: end with an end-of-stream code, no rewind of outfile.");
+	fprintf(stderr, "\n       t = streaming, with the size and CRC-32 of the data at the end.");
+	fprintf(stderr, "\n       T = independent blocks of B MB (B = 1..1024, default=8),");
+	fprintf(stderr, "\n           coded on K threads (default: all processors); with d,");
+	fprintf(stderr, "\n           the threads that decode such a file's blocks.");
+	fprintf(stderr, "\n       p = each block primed with the window before it (decoded in order).");
+	fprintf(stderr, "\n       m = one stream, its matches found in 1 MB ranges of infile on K threads.");
+	fprintf(stderr, "\n       l = infile is a list of files (one a line) or a directory, coded with");
+	fprintf(stderr, "\n           -T into the archive outfile; with d, outfile is a directory.");
+	fprintf(stderr, "\n       v = with -T, -m or -l, code infile again on one thread and compare");
+	fprintf(stderr, "\n           (exit status 1 if outfile differs).");
+	fprintf(stderr, "\n       n = with -T, -m or -l (or d), pin the threads to processors, one NUMA");
+	fprintf(stderr, "\n           node after another; a block is coded from a copy on its node.");
+	fprintf(stderr, "\n       d = decoding.");
+	fprintf(stderr, "\n       r = with d, only the L bytes of the data from byte F (a -T file without -p).");
+	fprintf(stderr, "\n       infile or outfile \"-\" = stdin or stdout.");
+	copyright();
+	exit (0);
+}
+
+int main( int argc, char *argv[] )
+{
+	float ratio = 0.0;
+	int mode = -1, in_argn = 0, out_argn = 0, fcount = 0, n;
+	int stream_flags = 0, block_threads = 0, block_size = 0, parse_threads = 0;
+	int batch = 0, nnames = 0, name_skip = 0, check = 0, status = 0, range = 0;
+	long long range_from = 0, range_len = 0;
+	char **names = NULL;
+	
+	clock_t start_time = clock();
+	
+	/* command-line handler */
+	if ( argc < 3 || argc > 9 ) usage();
+	else if ( argc == 3 ) mode = COMPRESS;
+	n = 1;
+	while ( n < argc ){
+		if ( argv[n][0] == '-' && argv[n][1] == 'T' ){  /* -t is taken. */
+			block_threads = argv[n][2] != 0 ? atoi(&argv[n][2]) : num_cpus();
+			if ( block_threads < 1 || block_threads > 256 ) usage();
+		}
+		else if ( argv[n][0] == '-' && argv[n][1] != 0 ){
+			switch( tolower(argv[n][1]) ){
+				case 'c':
+					if ( argv[n][2] != 0 ){
+						num_POS_BITS = atoi(&argv[n][2]);
+						if ( num_POS_BITS < 12 ) usage();
+						else if ( num_POS_BITS > 20 ) usage();
+					}
+					if ( mode == DECOMPRESS ) usage();
+					else mode = COMPRESS;
+					break;
+				case 'f':
+					far_LIST_BITS = atoi(&argv[n][2]);
+					if ( far_LIST_BITS == 0 ) usage();
+					else if ( far_LIST_BITS < 1 ) far_LIST_BITS = 1;
+					else if ( far_LIST_BITS > 12 ) far_LIST_BITS = 12;
+					far_LIST = 1<<far_LIST_BITS;
+					if ( mode == DECOMPRESS ) usage();
+					else mode = COMPRESS;
+					break;
+				case 's': case 't':
+					if ( argv[n][2] != 0 || mode == DECOMPRESS ) usage();
+					stream_flags |= LZUF_STREAM;
+					if ( tolower(argv[n][1]) == 't' ) stream_flags |= LZUF_TRAILER;
+					mode = COMPRESS;
+					break;
+				case 'b':
+					block_size = atoi(&argv[n][2]);
+					if ( block_size < 1 || block_size > 1024 || mode == DECOMPRESS ) usage();
+					mode = COMPRESS;
+					break;
+				case 'p':
+					if ( argv[n][2] != 0 || mode == DECOMPRESS ) usage();
+					stream_flags |= LZUF_PRIMED;
+					mode = COMPRESS;
+					break;
+				case 'l':
+					if ( argv[n][2] != 0 || mode == DECOMPRESS ) usage();
+					batch = 1;
+					mode = COMPRESS;
+					break;
+				case 'v':
+					if ( argv[n][2] != 0 || mode == DECOMPRESS ) usage();
+					check = 1;
+					mode = COMPRESS;
+					break;
+				case 'n':
+					if ( argv[n][2] != 0 ) usage();
+					pin_threads = 1;
+					break;
+				case 'm':
+					parse_threads = argv[n][2] != 0 ? atoi(&argv[n][2]) : num_cpus();
+					if ( parse_threads < 1 || parse_threads > 256 || mode == DECOMPRESS ) usage();
+					mode = COMPRESS;
+					break;
+				case 'd':
+					if ( argv[n][2] != 0 || mode == COMPRESS ) usage();
+					mode = DECOMPRESS;
+					break;
+				case 'r':
+					if ( sscanf( &argv[n][2], "%lld,%lld", &range_from, &range_len ) != 2
+						|| range_from < 0 || range_len < 0 || mode == COMPRESS ) usage();
+					range = 1;
+					mode = DECOMPRESS;
+					break;
+				default: usage();
+			}
+		}
+		else {
+			if ( in_argn == 0 ) in_argn = n;
+			else if ( out_argn == 0 ) out_argn = n;
+			if ( ++fcount == 3 ) usage();
+		}
+		++n;
+	}
+	if ( in_argn == 0 || out_argn == 0 ) usage();
+	if ( batch ) {
+		if ( (stream_flags & (LZUF_STREAM | LZUF_PRIMED)) || parse_threads ) usage();
+		if ( !block_threads ) block_threads = num_cpus();
+	}
+	if ( check && !block_threads && !parse_threads ) usage();
+	if ( (block_size || (stream_flags & LZUF_PRIMED)) && !block_threads ) usage();
+	if ( block_threads && ((stream_flags & LZUF_TRAILER) || parse_threads) ) usage();
+	if ( mode == -1 ) mode = COMPRESS;  /* -T alone. */
+	if ( pin_threads && mode == COMPRESS && !block_threads && !parse_threads ) usage();
+	if ( block_threads && mode == COMPRESS ) {
+		stream_flags |= batch ? LZUF_ARCHIVE : LZUF_BLOCKS;
+		if ( !batch && !(stream_flags & LZUF_PRIMED) ) stream_flags |= LZUF_INDEXED;
+		if ( block_size == 0 ) block_size = BLOCK_MB;
+	}
+	
+	init_buffer_sizes( (1<<20) );
+	
+	if ( batch ) {
+		if ( (names = read_names( argv[ in_argn ], &nnames, &name_skip )) == NULL ) return 0;
+	}
+	else if ( (gIN = open_file(argv[ in_argn ], "rb")) == NULL ) {
+		fprintf(stderr, "\nError opening input file.");
+		return 0;
+	}
+	if ( mode == DECOMPRESS ) fread( &fstamp, sizeof(file_stamp), 1, gIN );
+	/* an archive is extracted into a directory. */
+	if ( !(mode == DECOMPRESS && (fstamp.flags & LZUF_ARCHIVE))
+			&& (pOUT = open_file(argv[ out_argn ], "wb")) == NULL ) {
+		fprintf(stderr, "\nError opening output file." );
+		return 0;
+	}
+	/* an output that can't be rewound gets a stream. */
+	if ( mode == COMPRESS && file_tell( pOUT ) < 0 ) stream_flags |= LZUF_STREAM;
+	if ( pOUT ) init_put_buffer();  /* none for an archive's directory. */
+	init_crc32();
+	
+	/* initialize MTF list. */
+	alloc_mtf(MTF_SIZE);
+	
+	/* ---- adaptive Huffman initializations ---- */
+	hmax_symbols = H_MAX;
+	hsymbol_bit_size = log2(H_MAX);
+	fgk_init_first_node( hmin=0 );
+	
+	if ( mode == COMPRESS ){
+		/* initialize */
+		win_BUFSIZE  = 1<<num_POS_BITS;   /* must be a power of 2. */
+		win_MASK     = win_BUFSIZE-1;
+		hash_SHIFT   = num_POS_BITS-8;
+		pat_BUFSIZE  = win_BUFSIZE;    /* must be a power of 2. */
+		
+		/* Write the FILE STAMP. */
+		strcpy( fstamp.algorithm, "LZUF5" );
+		fstamp.num_pos_bits = num_POS_BITS;
+		fstamp.file_size = 0;  /* initial write. */
+		fstamp.flags = stream_flags;
+		fwrite( &fstamp, sizeof(file_stamp), 1, pOUT );
+		nbytes_out = sizeof(file_stamp);
+		
+		fprintf(stderr, "\nWindow Buffer size used  = %15lu bytes", (ulong) win_BUFSIZE );
+		fprintf(stderr, "\nLook-Ahead Buffer size   = %15lu bytes", (ulong) pat_BUFSIZE );
+		fprintf(stderr, "\n\nName of input file : %s", argv[ in_argn ] );
+		
+		/* start Compressing to output file. */
+		if ( fstamp.flags & LZUF_ARCHIVE ) {
+			fprintf(stderr, "\n Compressing %d files in %d MB blocks on %d threads...",
+				nnames, block_size, block_threads );
+			free_put_buffer();  /* the frames are written whole. */
+			if ( !compress_files( names, nnames, name_skip, block_threads,
+				(size_t) block_size << 20 ) ) goto halt_prog;
+		}
+		else if ( fstamp.flags & LZUF_BLOCKS ) {
+			fprintf(stderr, "\n Compressing %d MB blocks on %d threads...", block_size, block_threads );
+			free_put_buffer();  /* the frames are written whole. */
+			if ( !compress_blocks( block_threads, (size_t) block_size << 20 ) ) goto halt_prog;
+		}
+		else {
+			fprintf(stderr, "\n Compressing...");
+			
+			/* map or buffer the input. */
+			if ( !open_input_view( gIN ) ) goto halt_prog;
+			
+			if ( parse_threads && in_mapped ) {
+				if ( !compress_ranges( parse_threads ) ) goto halt_prog;
+			}
+			else {
+				/* initialize the table of pointers. */
+				if ( !alloc_lzhash(win_BUFSIZE) ) goto halt_prog;
+#ifdef LZUF_THREADS
+				if ( num_cpus() < 2 || !compress_pipeline() )
+#endif
+				compress();
+			}
+			if ( fstamp.flags & LZUF_STREAM ) put_end_of_stream();
+		}
+		fprintf(stderr, "complete.");
+	}
+	else if ( mode == DECOMPRESS ){
+		fprintf(stderr, "\n Name of input  file : %s", argv[in_argn] );
+		fprintf(stderr, "\n Name of output file : %s", argv[out_argn] );
+		fprintf(stderr, "\n\n  Decompressing...");
+		if ( strcmp( fstamp.algorithm, "LZUF5" ) ) {
+			fprintf(stderr, "\nNot an LZUF5 file.");
+			goto halt_prog;
+		}
+		if ( fstamp.num_pos_bits < 12 || fstamp.num_pos_bits > 20 ) {
+			fprintf(stderr, "\nCorrupt input file. ");
+			goto halt_prog;
+		}
+		if ( range ) {
+			free_put_buffer();  /* the blocks are written whole. */
+			if ( !(fstamp.flags & LZUF_INDEXED) ) {
+				fprintf(stderr, "\nNo block index (a -T file, coded without -p, has one).");
+			}
+			else if ( !extract_range( range_from, range_len ) ) {
+				fprintf(stderr, "\nCorrupt input file, or it can't be seeked. ");
+			}
+		}
+		else if ( fstamp.flags & LZUF_ARCHIVE ) {
+			free_put_buffer();  /* the blocks are written whole. */
+			if ( !extract_files( argv[out_argn], block_threads ? block_threads : num_cpus() ) ) {
+				fprintf(stderr, "\nCorrupt input file. ");
+			}
+		}
+		else if ( fstamp.flags & LZUF_BLOCKS ) {
+			free_put_buffer();  /* the blocks are written whole. */
+			if ( !decompress_blocks( block_threads ? block_threads : num_cpus() ) ) {
+				fprintf(stderr, "\nCorrupt input file. ");
+			}
+		}
+		else {
+			init_get_buffer();
+			nbytes_read = sizeof(file_stamp);
+			
+			/* initialize */
+			num_POS_BITS = fstamp.num_pos_bits;
+			win_BUFSIZE  = 1<<num_POS_BITS;   /* must be a power of 2. */
+			hash_SHIFT   = num_POS_BITS-8;
+			win_MASK     = win_BUFSIZE-1;
+			pat_BUFSIZE  = win_BUFSIZE;    /* must be a power of 2. */
+			
+			/* map or buffer the output. */
+			if ( !open_output_view( pOUT, fstamp.file_size ) ) goto halt_prog;
+			
+			if ( !decompress() ) fprintf(stderr, "\nCorrupt input file. ");
+		}
+		nbytes_out = out_cur;
+		fprintf( stderr, "done.\n" );
+	}
+	flush_put_buffer();
+	
+	/* get infile's size and get compression ratio. */
+	if ( mode == COMPRESS ) nbytes_read = in_cur;
+	else if ( !(fstamp.flags & (LZUF_BLOCKS | LZUF_ARCHIVE)) && !range ) nbytes_read = get_nbytes_read();
+	
+	if ( mode == COMPRESS ){
+		/* re-Write the FILE STAMP. */
+		if ( !(fstamp.flags & LZUF_STREAM) ) {
+			rewind( pOUT );
+			fstamp.file_size = nbytes_read; /* actual input file length. */
+			fwrite( &fstamp, sizeof(file_stamp), 1, pOUT );
+		}
+		fprintf(stderr, "\nName of output file: %s", argv[ out_argn ] );
+		fprintf(stderr, "\nLength of input file     = %15llu bytes", nbytes_read );
+		fprintf(stderr, "\nLength of output file    = %15llu bytes", nbytes_out );
+		
+		ratio = (((float) nbytes_read - (float) nbytes_out) /
+			(float) nbytes_read ) * (float) 100;
+		fprintf(stderr, "\nCompression ratio:         %15.2f %% ", ratio );
+		if ( check ) {
+			switch ( check_output( argv[ out_argn ], names, nnames, name_skip, (size_t) block_size << 20 ) ) {
+				case 1: fprintf(stderr, "\nChecked: the same output on one thread."); break;
+				case 0: fprintf(stderr, "\nCheck FAILED: the output on one thread differs."); status = 1; break;
+				default: fprintf(stderr, "\nCan't check: the input or the output can't be read again.");
+			}
+		}
+	}
+	else if ( mode == DECOMPRESS ){
+		fprintf(stderr, "  (%lld) -> (%lld)", nbytes_read, nbytes_out);
+	}
+	
+	halt_prog:
+	
+	free_put_buffer();
+	free_get_buffer();
+	free_lzhash();
+	free_mtf_table();
+	close_input_view();
+	close_output_view();
+	if ( gIN ) fclose( gIN );
+	if ( pOUT ) fclose( pOUT );
+	while ( nnames ) free( names[ --nnames ] );
+	free( names );
+	if ( mode == DECOMPRESS ) nbytes_read = nbytes_out;
+	fprintf(stderr, " in %3.2f secs (@ %3.2f MB/s)",
+		(double)(clock()-start_time) / CLOCKS_PER_SEC, (nbytes_read/1048576)/((double)(clock()-start_time)/ CLOCKS_PER_SEC) );
+	copyright();
+	return status;
+}
+
+/*
+-T: the input is cut into blocks of bsize bytes, each coded on
+its own by compress_block(), so that any number of them can be
+coded, or decoded, at once. After the file stamp (LZUF_BLOCKS),
+each block is a frame:
+
+	size          4 bytes, least significant first;
+	coded size    4 bytes; the same as size if stored;
+	the coded or stored block,
+
+and a frame of size 0 ends them. Without -p, the block index
+follows (LZUF_INDEXED, see index_blocks()).
+
+The blocks go round a ring of slots: the main thread reads into
+the free slots in order, the workers code or decode them, and
+the main thread writes them out in the same order. A decoder
+with a mapped output file has the workers decode straight into
+it, at each block's offset.
+
+With LZUF_PRIMED (-p), a slot also has the window before its block
+(the prime): the coder copies it from the previous block's input,
+so the blocks are still coded at once. The decoder needs it from
+the previous block's output, so it decodes the blocks in order.
+
+-m uses the ring to parse one stream (bp->parsing): a slot is a
+range of PARSE_RANGE bytes of the mapped input, the workers parse
+the ranges into tokens, each with its own hash lists primed with
+the window before its range, and the main thread codes the tokens
+in order. A match ends at the end of its range, so the tokens are
+the same for any number of threads.
+
+-l codes a list of files through one ring, block by block in list
+order: a small file is one block, a large one several, and the
+workers and slot buffers are kept from file to file. Each file's
+window is cut down to fit it (at least 12 bits), so a small file
+needs only small hash lists. The archive (LZUF_ARCHIVE) has, for
+each file:
+
+	name length   4 bytes, least significant first;
+	the name;
+	the file's -T stream (its file stamp, frames and end frame),
+
+and a name length of 0 ends it. -d extracts the files into a
+directory, decoding each one's blocks on the workers.
+
+In every mode, the bytes written depend only on the options (-c,
+-f, -b, -p; the -m ranges are always PARSE_RANGE bytes) and on
+whether outfile can be rewound, never on the number of threads or
+the order in which the workers finish: the blocks, primes and
+coder resets are fixed before any worker runs, and the output is
+written in order. -v checks this against a run on one thread.
+
+-n pins the workers to the processors this process may run on,
+taken one from each NUMA node in turn (as listed in /sys), so
+that K workers spread over the nodes. A worker sets up its codec
+tables (the MTF list; coding or parsing, the hash lists for the
+largest window) itself, once, when it starts, and only resets them
+from block to block, so these land on its own node; a coding
+worker also copies each block (and its prime) from the
+slot, read in by the main thread, to a buffer of its own first,
+since the search reads the block many times over.
+*/
+#define PARSE_RANGE  (1<<20)
+
+enum { SLOT_FREE, SLOT_READ, SLOT_BUSY, SLOT_DONE };
+
+typedef struct {
+	unsigned char *src, *dst;
+	size_t cap, dcap;  /* of src and dst. */
+	size_t n, cn;      /* block size; coded size, 0 if stored (or corrupt); parsing, the tokens. */
+	size_t prime;      /* the bytes of the window before the block. */
+	unsigned char *out;  /* decoding: in dst, or the block in the mapped output; parsing, the range. */
+	int bits;          /* coding: the window size. */
+	int file;          /* -l: the file this block starts, else -1; */
+	int64_t fsize;     /* and its size. */
+	int state;
+} block_slot;
+
+typedef struct {
+	block_slot *slot;
+	int nslots, decoding, parsing;
+	int64_t next;      /* the next block to code. */
+	int bits, list_bits;
+	size_t bsize;
+	size_t pre;        /* room for the prime before each block (LZUF_PRIMED). */
+	block_slot *prev;  /* the block read before. */
+	unsigned char *tail;  /* the decoder's last pre bytes of output (not mapped). */
+	int eof, error;
+	int64_t total, nread;
+	int64_t written;     /* decoding: the output of the blocks written out, in order. */
+	unsigned char *map;  /* the mapped output, or NULL. */
+	int64_t map_size;
+	parse_state ps;    /* parsing: the input view. */
+	char **names;      /* -l: the files, in order; */
+	int nnames, nfile, skip;  /* the next to open; the chars before each name to keep. */
+	int64_t left;      /* -l: the bytes of the open file not read yet; */
+	int fbits, wrote;  /* its window size; a file's frames are being written. */
+	int indexing;      /* the index of the blocks written: */
+	unsigned char *index;
+	int64_t nindex, index_cap, indexed;  /* its entries, its room, the data in them; */
+	int64_t coff;      /* the file offset of the next frame. */
+	int quit;
+	int *cpus, ncpus, npinned;  /* -n: the processors, in order; the workers pinned. */
+#ifdef LZUF_THREADS
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+#endif
+} block_pool;
+
+/* the slot's buffers, at least n bytes of src and dn bytes of dst. */
+static int slot_room( block_slot *s, size_t n, size_t dn )
+{
+	if ( n > s->cap ) {
+		free( s->src );
+		s->cap = (s->src = (unsigned char *) malloc( n )) != NULL ? n : 0;
+	}
+	if ( dn > s->dcap ) {
+		free( s->dst );
+		s->dcap = (s->dst = (unsigned char *) malloc( dn )) != NULL ? dn : 0;
+	}
+	if ( s->cap < n || s->dcap < dn ) {
+		fprintf(stderr, "\nError alloc: block buffers.");
+		return 0;
+	}
+	return 1;
+}
+
+#ifdef LZUF_THREADS
+/*
+A worker sets up its MTF list, and hash lists of hsize entries (0:
+none), once; then init_codec() and block_lzhash() only reset them.
+*/
+static void keep_codec( unsigned int hsize )
+{
+	if ( !alloc_mtf(MTF_SIZE) ) return;
+	codec_kept = 1;
+	if ( hsize && alloc_lzhash( (int) hsize ) ) hash_kept = hsize;
+}
+
+static void drop_codec( void )
+{
+	codec_kept = 0;
+	hash_kept = 0;
+	free_lzhash();
+	free_mtf_table();
+}
+#endif
+
+/* puts the thread's hash lists in ps. */
+static void save_lzhash( parse_state *ps )
+{
+	ps->lzhash = lzhash;
+	ps->lzprev = lzprev;
+	ps->lznext = lznext;
+	ps->hashp = hashp;
+}
+
+/* parses the range at s->out into tokens at s->src; s->cn = 0 on an error. */
+static void parse_slot( block_pool *bp, block_slot *s )
+{
+	parse_state own, ps;
+	lz_token *t = (lz_token *) s->src;
+	unsigned char *p;
+	unsigned int d;
+	int64_t end;
+	int i;
+	
+	save_parser( &own );  /* the main thread's, if it parses too. */
+	ps = bp->ps;
+	if ( codec_kept ) save_lzhash( &ps );  /* a worker's own hash lists. */
+	load_parser( &ps );
+	in_cur = (int64_t) (s->out - in_buf) + in_base;
+	end = in_cur + (int64_t) s->n;
+	for ( i = 0; i < NUM_REPS; i++ ) rep_dist[i] = i+1;
+	lit_miss = lit_skip = 0;
+	s->cn = 0;
+	if ( block_lzhash() ) {
+		prime_window();
+		while ( in_cur < end ) {
+			buf_cnt = end-in_cur > pat_BUFSIZE ? pat_BUFSIZE : (int) (end-in_cur);
+			p = in_buf + (in_cur-in_base);
+			
+			d = parse( p );
+			t[ s->cn ].d = d;
+			t[ s->cn ].len = d ? dpos.len : p[0];
+			s->cn++;
+			if ( d ) update_reps( d );
+			slide( p );
+		}
+	}
+	if ( codec_kept ) save_lzhash( &own );
+	else free_lzhash();
+	load_parser( &own );
+}
+
+/* a coded block must be shorter than the block. */
+static void code_slot( block_pool *bp, block_slot *s )
+{
+	size_t k;
+	
+	if ( bp->parsing ) {
+		parse_slot( bp, s );
+		return;
+	}
+	if ( !bp->decoding ) {
+		if ( s->n ) s->cn = compress_block( s->src + bp->pre, s->n, s->dst, s->n-1,
+			s->bits, bp->list_bits, s->prime );
+		return;
+	}
+	if ( s->prime && !bp->map ) memcpy( s->out - s->prime, bp->tail + bp->pre - s->prime, s->prime );
+	if ( s->cn == s->n ) memcpy( s->out, s->src, s->n );
+	else if ( !decompress_block( s->src, s->cn, s->out, s->n, bp->bits, s->prime ) ) s->cn = 0;
+	if ( bp->tail ) {
+		k = s->prime + s->n < bp->pre ? s->prime + s->n : bp->pre;
+		memcpy( bp->tail + bp->pre - k, s->out + s->n - k, k );
+	}
+}
+
+/* the size of the regular file f, or -1. */
+static int64_t file_size( FILE *f )
+{
+#ifdef LZUF_MMAP
+	struct stat st;
+	
+	if ( fstat( fileno(f), &st ) == 0 && S_ISREG(st.st_mode) ) return (int64_t) st.st_size;
+	return -1;
+#else
+	int64_t n = -1;
+	
+	if ( file_seek( f, 0, SEEK_END ) == 0 ) n = file_tell( f );
+	rewind( f );
+	return n;
+#endif
+}
+
+/* -l: reads the next block of the files, opening each in turn; 0 after the last. */
+static int read_file_slot( block_pool *bp, block_slot *s )
+{
+	size_t want;
+	
+	s->file = -1;
+	while ( !gIN ) {
+		if ( bp->nfile == bp->nnames ) {
+			bp->eof = 1;
+			return 0;
+		}
+		if ( (gIN = fopen( bp->names[ bp->nfile ], "rb" )) == NULL
+				|| (bp->left = file_size( gIN )) < 0 ) {
+			fprintf(stderr, "\nError opening input file %s; skipped.", bp->names[ bp->nfile ] );
+			if ( gIN ) fclose( gIN );
+			gIN = NULL;
+			bp->nfile++;
+			continue;
+		}
+		s->file = bp->nfile++;
+		s->fsize = bp->left;
+		for ( bp->fbits = 12; bp->fbits < bp->bits && ((int64_t) 1 << bp->fbits) < bp->left; bp->fbits++ ) ;
+	}
+	s->bits = bp->fbits;
+	want = bp->left < (int64_t) bp->bsize ? (size_t) bp->left : bp->bsize;
+	if ( (s->n = fread( s->src, 1, want, gIN )) < want ) {
+		fprintf(stderr, "\nError reading input file %s.", bp->names[ bp->nfile-1 ] );
+		return (bp->error = 1), 0;
+	}
+	bp->left -= s->n;
+	bp->total += s->n;
+	if ( bp->left == 0 ) {
+		fclose( gIN );
+		gIN = NULL;
+	}
+	return 1;
+}
+
+/* reads the next block or frame into s; 0 at the end (or on an error). */
+static int read_slot( block_pool *bp, block_slot *s )
+{
+	unsigned char h[8];
+	
+	s->prime = bp->total < (int64_t) bp->pre ? (size_t) bp->total : bp->pre;
+	if ( bp->parsing ) {
+		if ( bp->ps.in_end - bp->total < (int64_t) bp->bsize ) s->n = (size_t) (bp->ps.in_end - bp->total);
+		else s->n = bp->bsize;
+		if ( !slot_room( s, s->n * sizeof(lz_token), 0 ) ) return (bp->error = 1), 0;
+		s->out = bp->ps.in_buf + (bp->total - bp->ps.in_base);
+		bp->total += s->n;
+		if ( bp->total == bp->ps.in_end ) bp->eof = 1;
+		return s->n != 0;
+	}
+	if ( !bp->decoding ) {
+		if ( !slot_room( s, bp->pre + bp->bsize, bp->bsize ) ) return (bp->error = 1), 0;
+		if ( bp->names ) return read_file_slot( bp, s );
+		s->file = -1;
+		s->bits = bp->bits;
+		if ( s->prime ) {
+			memcpy( s->src + bp->pre - s->prime,
+				bp->prev->src + bp->pre + bp->prev->n - s->prime, s->prime );
+		}
+		if ( (s->n = fread( s->src + bp->pre, 1, bp->bsize, gIN )) < bp->bsize ) bp->eof = 1;
+		bp->total += s->n;
+		bp->prev = s;
+		return s->n != 0;
+	}
+	if ( fread( h, 1, 8, gIN ) != 8 ) return (bp->error = 1), 0;
+	bp->nread += 8;
+	s->n = get_le32( h );
+	s->cn = get_le32( h+4 );
+	if ( s->n == 0 ) {
+		bp->eof = 1;
+		if ( s->cn != 0 ) bp->error = 1;
+		return 0;
+	}
+	if ( s->n > BLOCK_MAX || s->cn == 0 || s->cn > s->n ) return (bp->error = 1), 0;
+	if ( bp->map && bp->total + (int64_t) s->n > bp->map_size ) return (bp->error = 1), 0;
+	if ( !slot_room( s, s->cn, bp->map ? 0 : bp->pre + s->n ) ) return (bp->error = 1), 0;
+	if ( fread( s->src, 1, s->cn, gIN ) != s->cn ) return (bp->error = 1), 0;
+	s->out = bp->map ? bp->map + bp->total : s->dst + bp->pre;
+	bp->nread += s->cn;
+	bp->total += s->n;
+	return 1;
+}
+
+/* -l: ends the file before, if any; starts the archive entry of s->file. */
+static void put_entry( block_pool *bp, block_slot *s )
+{
+	const char *name = bp->names[ s->file ] + bp->skip;
+	unsigned char h[8];
+	file_stamp fs;
+	size_t len;
+	
+	while ( *name == '/' ) name++;  /* extracted under a directory. */
+	len = strlen( name );
+	if ( bp->wrote ) {
+		memset( h, 0, 8 );  /* the end frame. */
+		fwrite( h, 1, 8, pOUT );
+		nbytes_out += 8;
+	}
+	put_le32( h, (uint32_t) len );
+	fwrite( h, 1, 4, pOUT );
+	fwrite( name, 1, len, pOUT );
+	memset( &fs, 0, sizeof(fs) );
+	strcpy( fs.algorithm, "LZUF5" );
+	fs.file_size = s->fsize;
+	fs.num_pos_bits = s->bits;
+	fs.flags = LZUF_BLOCKS;
+	fwrite( &fs, sizeof(file_stamp), 1, pOUT );
+	nbytes_out += 4 + len + sizeof(file_stamp);
+	bp->wrote = 1;
+}
+
+/* adds the block of frame header h, at bp->coff, to the index. */
+static int index_slot( block_pool *bp, unsigned char *h )
+{
+	unsigned char *p;
+	
+	if ( bp->nindex == bp->index_cap ) {
+		p = (unsigned char *) realloc( bp->index, (size_t) (bp->index_cap + 256) * INDEX_ENTRY );
+		if ( !p ) {
+			fprintf(stderr, "\nError alloc: block index.");
+			return 0;
+		}
+		bp->index = p;
+		bp->index_cap += 256;
+	}
+	p = bp->index + bp->nindex++ * INDEX_ENTRY;
+	put_le64( p, (uint64_t) bp->indexed );
+	put_le64( p+8, (uint64_t) bp->coff );
+	memcpy( p+16, h, 8 );
+	bp->indexed += get_le32( h );
+	bp->coff += 8 + get_le32( h+4 );
+	return 1;
+}
+
+/* writes out a coded block as a frame, or a decoded block; codes a parsed range. */
+static int write_slot( block_pool *bp, block_slot *s )
+{
+	lz_token *t = (lz_token *) s->src;
+	unsigned char h[8];
+	size_t i;
+	
+	if ( bp->parsing ) {
+		if ( s->cn == 0 ) return 0;  /* no memory. */
+		for ( i = 0; i < s->cn; i++ ) put_token( t[i].d, t[i].len );
+		return !p_mem_full;
+	}
+	if ( bp->decoding ) {
+		if ( s->cn == 0 ) return 0;  /* corrupt. */
+		if ( !bp->map ) fwrite( s->out, 1, s->n, pOUT );
+		bp->written += s->n;
+		return 1;
+	}
+	if ( s->file >= 0 ) put_entry( bp, s );  /* -l: the next file. */
+	if ( s->n == 0 ) return 1;
+	put_le32( h, (uint32_t) s->n );
+	put_le32( h+4, (uint32_t) (s->cn ? s->cn : s->n) );
+	if ( bp->indexing && !index_slot( bp, h ) ) return 0;
+	fwrite( h, 1, 8, pOUT );
+	fwrite( s->cn ? s->dst : s->src + bp->pre, 1, s->cn ? s->cn : s->n, pOUT );
+	nbytes_out += 8 + (s->cn ? s->cn : s->n);
+	return 1;
+}
+
+#ifdef LZUF_PIN
+#define PIN_CPUS   1024   /* the processors */
+#define PIN_NODES    64   /* and NUMA nodes looked at. */
+#define CPU_WORD   (8*sizeof(unsigned long))
+
+static int cmp_ints( const void *a, const void *b )
+{
+	return *(const int *) a - *(const int *) b;
+}
+
+/* the processors we may run on, the first of each node, then the second...; their number. */
+static int pin_order( int *cpu )
+{
+	unsigned long mask[ PIN_CPUS / CPU_WORD ];
+	int node[ PIN_CPUS ], rank[ PIN_NODES ];
+	char name[64];
+	FILE *f;
+	int c, d, a, b, ch, n = 0;
+	
+	memset( mask, 0, sizeof(mask) );
+	if ( syscall( __NR_sched_getaffinity, 0, sizeof(mask), mask ) <= 0 ) return 0;
+	memset( node, 0, sizeof(node) );
+	for ( d = 0; d < PIN_NODES; d++ ) {
+		sprintf( name, "/sys/devices/system/node/node%d/cpulist", d );
+		if ( (f = fopen( name, "r" )) == NULL ) continue;
+		while ( fscanf( f, "%d", &a ) == 1 ) {  /* e.g. "0-7,16-23". */
+			b = a;
+			if ( (ch = fgetc( f )) == '-' ) {
+				if ( fscanf( f, "%d", &b ) != 1 ) break;
+				ch = fgetc( f );
+			}
+			for ( ; a <= b && a < PIN_CPUS; a++ ) if ( a >= 0 ) node[a] = d;
+			if ( ch != ',' ) break;
+		}
+		fclose( f );
+	}
+	memset( rank, 0, sizeof(rank) );
+	for ( c = 0; c < PIN_CPUS; c++ ) {
+		if ( (mask[ c / CPU_WORD ] >> (c % CPU_WORD)) & 1 )
+			cpu[n++] = (rank[ node[c] ]++ * PIN_NODES + node[c]) * PIN_CPUS + c;
+	}
+	qsort( cpu, n, sizeof(int), cmp_ints );
+	for ( c = 0; c < n; c++ ) cpu[c] %= PIN_CPUS;
+	return n;
+}
+
+static void pin_thread( int cpu )
+{
+	unsigned long mask[ PIN_CPUS / CPU_WORD ];
+	
+	memset( mask, 0, sizeof(mask) );
+	mask[ cpu / CPU_WORD ] = 1UL << (cpu % CPU_WORD);
+	syscall( __NR_sched_setaffinity, 0, sizeof(mask), mask );
+}
+#endif
+
+#ifdef LZUF_THREADS
+static void *block_worker( void *arg )
+{
+	block_pool *bp = (block_pool *) arg;
+	block_slot *s, t;
+	unsigned char *own = NULL;  /* -n: the block, copied on this thread's node. */
+#ifdef LZUF_PIN
+	int cpu = -1;
+	
+	pthread_mutex_lock( &bp->lock );
+	if ( bp->cpus ) cpu = bp->cpus[ bp->npinned++ % bp->ncpus ];
+	pthread_mutex_unlock( &bp->lock );
+	if ( cpu >= 0 ) {
+		pin_thread( cpu );
+		if ( !bp->decoding && !bp->parsing ) own = (unsigned char *) malloc( bp->pre + bp->bsize );
+	}
+#endif
+	
+	/* the codec's tables, for all of the worker's blocks. */
+	keep_codec( bp->parsing ? bp->ps.win_BUFSIZE : bp->decoding ? 0 : 1u << bp->bits );
+	pthread_mutex_lock( &bp->lock );
+	while ( !bp->quit ) {
+		s = &bp->slot[ bp->next % bp->nslots ];
+		if ( s->state != SLOT_READ ) {
+			pthread_cond_wait( &bp->cond, &bp->lock );
+			continue;
+		}
+		s->state = SLOT_BUSY;
+		bp->next++;
+		pthread_mutex_unlock( &bp->lock );
+		if ( own && s->n ) {
+			t = *s;
+			t.src = own;
+			memcpy( own + bp->pre - s->prime, s->src + bp->pre - s->prime, s->prime + s->n );
+			code_slot( bp, &t );
+			s->cn = t.cn;
+		}
+		else code_slot( bp, s );
+		pthread_mutex_lock( &bp->lock );
+		s->state = SLOT_DONE;
+		pthread_cond_broadcast( &bp->cond );
+	}
+	pthread_mutex_unlock( &bp->lock );
+	drop_codec();
+	free( own );
+	return NULL;
+}
+
+static void set_slot( block_pool *bp, block_slot *s, int state )
+{
+	pthread_mutex_lock( &bp->lock );
+	s->state = state;
+	pthread_cond_broadcast( &bp->cond );
+	pthread_mutex_unlock( &bp->lock );
+}
+#else
+	#define set_slot(bp, s, st)  ((s)->state = (st))
+#endif
+
+/* codes or decodes all of the blocks on nthreads workers; 0 on an error. */
+static int run_blocks( block_pool *bp, int nthreads )
+{
+	file_stamp fs = fstamp;   /* each block starts the codec anew. */
+	block_slot *s;
+	int64_t rd = 0, wr = 0, nout;
+	int i, nworkers = 0;
+#ifdef LZUF_THREADS
+	pthread_t *tid = (pthread_t *) malloc( sizeof(pthread_t) * (nthreads+1) );
+	
+	if ( !tid ) return 0;
+#endif
+	
+	bp->nslots = nthreads + 2;  /* one being read, one being written. */
+	bp->slot = (block_slot *) calloc( bp->nslots, sizeof(block_slot) );
+	if ( !bp->slot ) bp->error = 1;
+#ifdef LZUF_THREADS
+	pthread_mutex_init( &bp->lock, NULL );
+	pthread_cond_init( &bp->cond, NULL );
+#ifdef LZUF_PIN
+	if ( pin_threads && nthreads && (bp->cpus = (int *) malloc( sizeof(int) * PIN_CPUS )) != NULL
+			&& (bp->ncpus = pin_order( bp->cpus )) == 0 ) {
+		free( bp->cpus );
+		bp->cpus = NULL;
+	}
+#endif
+	while ( bp->slot && nworkers < nthreads
+		&& pthread_create( &tid[nworkers], NULL, block_worker, bp ) == 0 ) nworkers++;
+#endif
+	
+	while ( bp->slot ) {
+		/* read ahead into the free slots. */
+		while ( !bp->eof && !bp->error && rd-wr < bp->nslots ) {
+			s = &bp->slot[ rd % bp->nslots ];
+			if ( !read_slot( bp, s ) ) break;
+			set_slot( bp, s, SLOT_READ );
+			rd++;
+		}
+		if ( wr == rd ) break;
+		
+		/* write out the oldest block, once done. */
+		s = &bp->slot[ wr % bp->nslots ];
+		if ( nworkers == 0 ) {
+			nout = nbytes_out;  /* a block coded here resets it. */
+			code_slot( bp, s );
+			nbytes_out = nout;
+			s->state = SLOT_DONE;
+		}
+#ifdef LZUF_THREADS
+		pthread_mutex_lock( &bp->lock );
+		while ( s->state != SLOT_DONE ) pthread_cond_wait( &bp->cond, &bp->lock );
+		pthread_mutex_unlock( &bp->lock );
+#endif
+		if ( !write_slot( bp, s ) ) {
+			bp->error = 1;
+			rd = wr;  /* the blocks in the slots are dropped. */
+		}
+		set_slot( bp, s, SLOT_FREE );
+		if ( wr < rd ) wr++;
+	}
+	
+#ifdef LZUF_THREADS
+	pthread_mutex_lock( &bp->lock );
+	bp->quit = 1;
+	pthread_cond_broadcast( &bp->cond );
+	pthread_mutex_unlock( &bp->lock );
+	while ( nworkers ) pthread_join( tid[--nworkers], NULL );
+	pthread_mutex_destroy( &bp->lock );
+	pthread_cond_destroy( &bp->cond );
+	free( bp->cpus );
+	free( tid );
+#endif
+	if ( bp->slot ) {
+		for ( i = 0; i < bp->nslots; i++ ) {
+			free( bp->slot[i].src );
+			free( bp->slot[i].dst );
+		}
+		free( bp->slot );
+	}
+	fstamp = fs;
+	return !bp->error;
+}
+
+int compress_blocks( int nthreads, size_t bsize )
+{
+	block_pool bp;
+	unsigned char h[8];
+	int ok;
+	
+	free_mtf_table();  /* a block coded here sets up its own codec. */
+	memset( &bp, 0, sizeof(bp) );
+	bp.bits = num_POS_BITS;
+	bp.list_bits = far_LIST_BITS;
+	bp.bsize = bsize;
+	if ( fstamp.flags & LZUF_PRIMED ) bp.pre = (size_t) 1 << bp.bits;
+	bp.indexing = (fstamp.flags & LZUF_INDEXED) != 0;
+	bp.coff = sizeof(file_stamp);  /* the frames follow the file stamp. */
+	if ( (ok = run_blocks( &bp, nthreads )) != 0 ) {
+		memset( h, 0, 8 );  /* the end. */
+		fwrite( h, 1, 8, pOUT );
+		nbytes_out += 8;
+		if ( bp.indexing ) {
+			fwrite( bp.index, INDEX_ENTRY, (size_t) bp.nindex, pOUT );
+			put_le64( h, (uint64_t) bp.nindex );
+			fwrite( h, 1, 8, pOUT );
+			fwrite( INDEX_MAGIC, 1, 8, pOUT );
+			nbytes_out += bp.nindex * INDEX_ENTRY + INDEX_FOOTER;
+		}
+	}
+	free( bp.index );
+	in_cur = bp.total;
+	return ok;
+}
+
+/* -m: parses the mapped input in ranges on nthreads workers; codes it as one stream. */
+int compress_ranges( int nthreads )
+{
+	block_pool bp;
+	int ok;
+	
+	memset( &bp, 0, sizeof(bp) );
+	bp.parsing = 1;
+	bp.bsize = PARSE_RANGE;
+	save_parser( &bp.ps );
+	ok = run_blocks( &bp, nthreads );
+	if ( lit_cnt ) put_literals();
+	in_cur = bp.total;
+	return ok;
+}
+
+/* decodes the frames of a -T file on nthreads workers. */
+int decompress_blocks( int nthreads )
+{
+	block_pool bp;
+	int ok;
+	
+	free_mtf_table();  /* a block decoded here sets up its own codec. */
+	memset( &bp, 0, sizeof(bp) );
+	bp.decoding = 1;
+	bp.bits = fstamp.num_pos_bits;
+	bp.nread = sizeof(file_stamp);
+	if ( bp.bits < 12 || bp.bits > 20 ) return 0;
+	if ( (bp.map = map_output( pOUT, fstamp.file_size )) != NULL ) bp.map_size = fstamp.file_size;
+	if ( fstamp.flags & LZUF_PRIMED ) {
+		bp.pre = (size_t) 1 << bp.bits;
+		nthreads = 0;  /* each block needs the one before. */
+		if ( !bp.map && (bp.tail = (unsigned char *) malloc( bp.pre )) == NULL ) return 0;
+	}
+	ok = run_blocks( &bp, nthreads ) && bp.eof && (!bp.map || bp.total == bp.map_size);
+	free( bp.tail );
+#ifdef LZUF_MMAP
+	if ( bp.map ) {
+		munmap( bp.map, (size_t) bp.map_size );
+		/* corrupt or cut short: only the blocks decoded, in order. */
+		if ( !ok ) ftruncate( fileno(pOUT), (off_t) bp.written );
+	}
+#endif
+	out_cur = bp.written;
+	nbytes_read = bp.nread;
+	return ok;
+}
+
+#ifdef LZUF_DIRS
+static int cmp_names( const void *a, const void *b )
+{
+	return strcmp( *(char * const *) a, *(char * const *) b );
+}
+#endif
+
+/* a new entry of len+1 chars at the end of the names; NULL if out of memory. */
+static char *add_name( char ***names, int n, int *size, size_t len )
+{
+	char **t;
+	
+	if ( n == *size ) {
+		*size = *size ? *size * 2 : 256;
+		if ( (t = (char **) realloc( *names, sizeof(char *) * *size )) == NULL ) return NULL;
+		*names = t;
+	}
+	return (*names)[n] = (char *) malloc( len+1 );
+}
+
+/*
+-l: the files to code, from a list (one name a line; "-" for stdin),
+or the regular files of a directory, by name; skip is the length
+of the directory's prefix of each name. NULL on an error.
+*/
+char **read_names( char *arg, int *nnames, int *skip )
+{
+	char **names = NULL, *p, line[ NAME_MAX_LEN+2 ];
+	int n = 0, size = 0, err = 0;
+	size_t len;
+	FILE *f;
+#ifdef LZUF_DIRS
+	DIR *d = opendir( arg );
+	struct dirent *de;
+	struct stat st;
+#endif
+	
+	*skip = 0;
+#ifdef LZUF_DIRS
+	if ( d ) {
+		*skip = (int) strlen( arg ) + 1;
+		while ( (de = readdir( d )) != NULL ) {
+			if ( (p = add_name( &names, n, &size, *skip + strlen( de->d_name ) )) == NULL ) break;
+			sprintf( p, "%s/%s", arg, de->d_name );
+			if ( stat( p, &st ) == 0 && S_ISREG(st.st_mode) ) n++;
+			else free( p );
+		}
+		closedir( d );
+		err = de != NULL;
+		if ( n ) qsort( names, n, sizeof(char *), cmp_names );
+	}
+	else
+#endif
+	{
+		if ( (f = open_file( arg, "r" )) == NULL ) return NULL;
+		while ( !err && fgets( line, sizeof(line), f ) ) {
+			len = strlen( line );
+			while ( len && (line[len-1] == '\n' || line[len-1] == '\r') ) line[--len] = 0;
+			if ( len == 0 ) continue;
+			if ( len > NAME_MAX_LEN || (p = add_name( &names, n, &size, len )) == NULL ) err = 1;
+			else {
+				strcpy( p, line );
+				n++;
+			}
+		}
+		if ( f != stdin ) fclose( f );
+	}
+	if ( !err && !names ) err = (names = (char **) malloc( sizeof(char *) )) == NULL;
+	if ( err ) {
+		fprintf(stderr, "\nError reading the file names.");
+		return NULL;
+	}
+	*nnames = n;
+	return names;
+}
+
+/* -l: codes the files on nthreads workers, into an archive. */
+int compress_files( char **names, int nnames, int skip, int nthreads, size_t bsize )
+{
+	block_pool bp;
+	unsigned char h[8];
+	
+	free_mtf_table();  /* a block coded here sets up its own codec. */
+	memset( &bp, 0, sizeof(bp) );
+	bp.bits = num_POS_BITS;
+	bp.list_bits = far_LIST_BITS;
+	bp.bsize = bsize;
+	bp.names = names;
+	bp.nnames = nnames;
+	bp.skip = skip;
+	if ( !run_blocks( &bp, nthreads ) ) return 0;
+	memset( h, 0, 8 );
+	if ( bp.wrote ) {
+		fwrite( h, 1, 8, pOUT );  /* the last file's end frame. */
+		nbytes_out += 8;
+	}
+	fwrite( h, 1, 4, pOUT );  /* the end of the archive. */
+	nbytes_out += 4;
+	in_cur = bp.total;
+	return 1;
+}
+
+/* 1 if the files f and g hold the same bytes. */
+static int same_files( FILE *f, FILE *g )
+{
+	unsigned char a[ 1<<15 ], b[ 1<<15 ];
+	size_t n;
+	
+	rewind( f );
+	rewind( g );
+	do {
+		n = fread( a, 1, sizeof(a), f );
+		if ( fread( b, 1, sizeof(b), g ) != n || memcmp( a, b, n ) ) return 0;
+	} while ( n == sizeof(a) );
+	return 1;
+}
+
+/*
+-v: codes the input again with one thread (-T1, -m1) into a
+temporary file, and compares it with the output file. Block
+boundaries, primes and coder resets depend only on the options,
+so the two must be the same. 1 if they are, 0 if not, -1 if it
+can't check (the output is "-", or the input can't be read again).
+*/
+int check_output( char *outname, char **names, int nnames, int skip, size_t bsize )
+{
+	FILE *out = pOUT, *ref = NULL, *tmp = NULL;
+	int64_t nout = nbytes_out;
+	file_stamp fs = fstamp;
+	parse_state ps;
+	int i, ok = 0, same = -1;
+	
+	fflush( pOUT );
+	if ( strcmp( outname, "-" ) && (ref = fopen( outname, "rb" )) != NULL
+			&& (tmp = tmpfile()) != NULL ) {
+		pOUT = tmp;
+		fwrite( &fstamp, sizeof(file_stamp), 1, pOUT );
+		if ( fstamp.flags & LZUF_ARCHIVE ) ok = compress_files( names, nnames, skip, 1, bsize );
+		else if ( fstamp.flags & LZUF_BLOCKS ) {
+			ok = file_seek( gIN, 0, SEEK_SET ) == 0 && compress_blocks( 1, bsize );
+		}
+		else if ( in_mapped ) {  /* -m; a new coder over the same input view. */
+			save_parser( &ps );
+			free_put_buffer();
+			free_mtf_table();
+			if ( init_codec( num_POS_BITS, far_LIST_BITS ) ) {
+				load_parser( &ps );
+				for ( i = 0; i < NUM_REPS; i++ ) rep_dist[i] = i+1;  /* not the first run's. */
+				in_cur = in_base;
+				fstamp = fs;
+				init_put_buffer();
+				ok = compress_ranges( 1 );
+				if ( fstamp.flags & LZUF_STREAM ) put_end_of_stream();
+				flush_put_buffer();
+			}
+		}
+		if ( ok ) same = same_files( ref, tmp );
+	}
+	if ( ref ) fclose( ref );
+	if ( tmp ) fclose( tmp );
+	pOUT = out;
+	nbytes_out = nout;
+	fstamp = fs;
+	return same;
+}
+
+/* a name to extract to: relative, without a ".." part. */
+static int safe_name( const char *p )
+{
+	if ( *p == 0 || *p == '/' || *p == '\\' || strchr( p, ':' ) ) return 0;
+	while ( *p ) {
+		if ( p[0] == '.' && p[1] == '.' && (p[2] == 0 || p[2] == '/' || p[2] == '\\') ) return 0;
+		while ( *p && *p != '/' && *p != '\\' ) p++;
+		if ( *p ) p++;
+	}
+	return 1;
+}
+
+/* -d of an archive: extracts its files into dir, each on nthreads workers. */
+int extract_files( char *dir, int nthreads )
+{
+	file_stamp as = fstamp;
+	unsigned char h[4];
+	char *path, *p;
+	size_t len, dlen = strlen( dir );
+	int64_t total = 0, nread = sizeof(file_stamp);
+	int ok = 1;
+	
+	if ( !strcmp( dir, "-" ) ) {
+		fprintf(stderr, "\nAn archive is extracted into a directory, not \"-\".");
+		return 0;
+	}
+	if ( (path = (char *) malloc( dlen + NAME_MAX_LEN + 2 )) == NULL ) return 0;
+	make_dir( dir );
+	while ( ok ) {
+		nread += 4;
+		if ( fread( h, 1, 4, gIN ) != 4 ) ok = 0;
+		else if ( (len = get_le32( h )) == 0 ) break;
+		else if ( len > NAME_MAX_LEN ) ok = 0;
+		if ( !ok ) break;
+		
+		sprintf( path, "%s/", dir );
+		if ( fread( path+dlen+1, 1, len, gIN ) != len ) {
+			ok = 0;
+			break;
+		}
+		path[ dlen+1+len ] = 0;
+		if ( !safe_name( path+dlen+1 ) ) {
+			fprintf(stderr, "\nUnsafe file name in archive: %s", path+dlen+1 );
+			ok = 0;
+			break;
+		}
+		/* the directories on the way. */
+		for ( p = path+dlen+1; (p = strchr( p, '/' )) != NULL; *p++ = '/' ) {
+			*p = 0;
+			make_dir( path );
+		}
+		if ( fread( &fstamp, sizeof(file_stamp), 1, gIN ) != 1
+				|| strcmp( fstamp.algorithm, "LZUF5" ) || !(fstamp.flags & LZUF_BLOCKS) ) {
+			ok = 0;
+			break;
+		}
+		if ( (pOUT = fopen( path, "wb" )) == NULL ) {
+			fprintf(stderr, "\nError opening output file %s.", path );
+			ok = 0;
+			break;
+		}
+		ok = decompress_blocks( nthreads );
+		fclose( pOUT );
+		pOUT = NULL;
+		total += out_cur;
+		nread += len + nbytes_read;
+	}
+	free( path );
+	fstamp = as;
+	out_cur = total;
+	nbytes_read = nread;
+	return ok;
+}
+
+/* -d -rFROM,LEN: writes LEN bytes of the data from FROM (or up to its end), decoding only their blocks. */
+int extract_range( int64_t from, int64_t len )
+{
+	unsigned char f[ INDEX_FOOTER ], *index = NULL, *e;
+	block_slot s;
+	int64_t fsize, nblocks, k, skip, coff, total = 0, nread = sizeof(file_stamp);
+	size_t n, cn, take;
+	int ok = 0, bits = fstamp.num_pos_bits;  /* a block decoded resets the codec's state. */
+	
+	free_mtf_table();  /* a block decoded here sets up its own codec. */
+	memset( &s, 0, sizeof(s) );
+	if ( file_seek( gIN, 0, SEEK_END ) != 0 || (fsize = file_tell( gIN )) < 0
+			|| fsize < (int64_t) sizeof(file_stamp) + INDEX_FOOTER
+			|| file_seek( gIN, fsize - INDEX_FOOTER, SEEK_SET ) != 0
+			|| fread( f, 1, INDEX_FOOTER, gIN ) != INDEX_FOOTER
+			|| (nblocks = index_blocks( f, fsize )) < 0 ) return 0;
+	if ( (index = (unsigned char *) malloc( (size_t) nblocks * INDEX_ENTRY + 1 )) == NULL
+			|| file_seek( gIN, fsize - INDEX_FOOTER - nblocks * INDEX_ENTRY, SEEK_SET ) != 0
+			|| fread( index, INDEX_ENTRY, (size_t) nblocks, gIN ) != (size_t) nblocks ) goto done;
+	nread += nblocks * INDEX_ENTRY + INDEX_FOOTER;
+	for ( k = find_block( index, nblocks, from ); k < nblocks && len > 0; k++ ) {
+		e = index + k * INDEX_ENTRY;
+		n = get_le32( e+16 );
+		cn = get_le32( e+20 );
+		coff = (int64_t) get_le64( e+8 );
+		skip = from - (int64_t) get_le64( e );
+		if ( n == 0 || n > BLOCK_MAX || cn == 0 || cn > n || skip < 0 ) goto done;
+		if ( skip >= (int64_t) n ) continue;  /* past the end of the data. */
+		if ( !slot_room( &s, 8 + cn, n ) || file_seek( gIN, coff, SEEK_SET ) != 0
+				|| fread( s.src, 1, 8 + cn, gIN ) != 8 + cn
+				|| memcmp( s.src, e+16, 8 ) ) goto done;  /* its frame. */
+		nread += 8 + cn;
+		if ( cn == n ) memcpy( s.dst, s.src + 8, n );
+		else if ( !decompress_block( s.src + 8, cn, s.dst, n, bits, 0 ) ) goto done;
+		take = (int64_t) n - skip < len ? n - (size_t) skip : (size_t) len;
+		fwrite( s.dst + skip, 1, take, pOUT );
+		total += take;
+		from += take;
+		len -= take;
+	}
+	ok = 1;
+	
+	done:
+	
+	free( s.src );
+	free( s.dst );
+	free( index );
+	out_cur = total;
+	nbytes_read = nread;
+	return ok;
+}
+#endif
+
+void copyright( void )
+{
+	fprintf(stderr, "\n\n Gerald R. Tamayo (c) 2008-2023\n");
+}
+
+/* the coder's and decoder's state, as at the start of a file. */
+void reset_state( void )
+{
+	agolomb_t len_init = { 4, 1, 2 }, run_init = { 1, 1, 0 };
+	int i;
+	
+	dpos.pos = dpos.len = 0;
+	win_cnt = buf_cnt = len_CODE = 0;
+	len_model = len_init;
+	run_model = run_init;
+	lit_cnt = lit_miss = lit_skip = 0;
+	for ( i = 0; i < NUM_REPS; i++ ) rep_dist[i] = i+1;
+	memset( &fstamp, 0, sizeof(file_stamp) );
+	data_crc = 0;
+	in_buf = NULL;
+	in_base = in_end = in_cur = 0;
+	in_mapped = in_eof = 0;
+	out_buf = NULL;
+	out_base = out_cur = out_done = 0;
+	out_mapped = 0;
+}
+
+/* sets up the window and the models for a new file. */
+int init_codec( int bits, int list_bits )
+{
+	reset_state();
+	num_POS_BITS = bits;
+	win_BUFSIZE  = 1<<num_POS_BITS;   /* must be a power of 2. */
+	win_MASK     = win_BUFSIZE-1;
+	hash_SHIFT   = num_POS_BITS-8;
+	pat_BUFSIZE  = win_BUFSIZE;    /* must be a power of 2. */
+	far_LIST_BITS = list_bits;
+	far_LIST = 1<<far_LIST_BITS;
+	out_ROOM = pat_BUFSIZE > LIT_RUN_MAX ? pat_BUFSIZE : LIT_RUN_MAX;
+	
+	/* initialize MTF list. */
+	if ( codec_kept ) init_mtf();
+	else if ( !alloc_mtf(MTF_SIZE) ) return 0;
+	
+	/* ---- adaptive Huffman initializations ---- */
+	hmax_symbols = H_MAX;
+	hsymbol_bit_size = log2(H_MAX);
+	hn = 0;
+	fgk_init_first_node( hmin=0 );
+	return 1;
+}
+
+void free_codec( void )
+{
+	free_memory_io();
+	if ( !codec_kept ) {
+		free_lzhash();
+		free_mtf_table();
+	}
+	in_buf = NULL;   /* the caller's. */
+	out_buf = NULL;
+	out_mapped = 0;
+}
+
+/* the hash lists for a block's window: a worker's, cleared, or new ones. */
+static int block_lzhash( void )
+{
+	if ( !codec_kept ) return alloc_lzhash( win_BUFSIZE );
+	if ( hash_kept < win_BUFSIZE ) {   /* a larger window than it set up. */
+		free_lzhash();
+		hash_kept = alloc_lzhash( win_BUFSIZE ) ? win_BUFSIZE : 0;
+		return hash_kept != 0;
+	}
+	reset_lzhash( win_BUFSIZE );
+	return 1;
+}
+
+/*
+Lists the (up to win_BUFSIZE) positions before in_cur, the prime,
+in the hash, as if they had just been coded; a position needs a
+4-byte string.
+*/
+static void prime_window( void )
+{
+	int64_t i = in_cur > (int64_t) win_BUFSIZE ? in_cur - win_BUFSIZE : in_base;
+	
+	for ( ; i < in_cur && i+HASH_BYTES_N <= in_end; i++ ) {
+		insert_lznode( hash(in_buf+(i-in_base)), (int) i & win_MASK );
+	}
+	win_cnt = (int) in_cur & win_MASK;
+}
+
+/*
+Codes the n bytes at src on their own (new models) into dst.
+The window starts with the prime (up to win_BUFSIZE) bytes before
+src, which aren't coded. Returns the coded size, or 0 if it is
+more than cap bytes (or there is no memory): then store the data.
+*/
+size_t compress_block( const unsigned char *src, size_t n,
+	unsigned char *dst, size_t cap, int bits, int list_bits, size_t prime )
+{
+	size_t cn = 0;
+	
+	if ( init_codec( bits, list_bits ) && block_lzhash() ) {
+		/* the coder's input view is the prime and the block. */
+		in_buf = (unsigned char *) src - prime;
+		in_cur = (int64_t) prime;
+		in_end = (int64_t) (prime + n);
+		in_eof = 1;
+		prime_window();
+		init_put_memory( dst, cap );
+		compress();
+		flush_put_buffer();
+		if ( !p_mem_full ) cn = (size_t) nbytes_out;
+	}
+	free_codec();
+	return cn;
+}
+
+/*
+Decodes a block of compress_block() into the n bytes at dst, with
+the same prime bytes before dst. Returns 0 if corrupt.
+*/
+int decompress_block( const unsigned char *src, size_t cn,
+	unsigned char *dst, size_t n, int bits, size_t prime )
+{
+	int ok = 0;
+	
+	if ( init_codec( bits, FAR_LIST_BITS ) ) {
+		fstamp.file_size = (int64_t) n;
+		out_buf = dst - prime;  /* the output view, at full size. */
+		out_cur = (int64_t) prime;
+		out_mapped = 1;
+		init_get_memory( (unsigned char *) src, cn );
+		ok = decompress();
+	}
+	free_codec();
+	return ok;
+}
+
+static void put_le32( unsigned char *p, uint32_t v )
+{
+	int i;
+	
+	for ( i = 0; i < 4; i++ ) p[i] = (unsigned char) (v >> (i*8));
+}
+
+#if !defined( LZUF_LIB )
+static void put_le64( unsigned char *p, uint64_t v )
+{
+	put_le32( p, (uint32_t) v );
+	put_le32( p+4, (uint32_t) (v >> 32) );
+}
+#endif
+
+static uint32_t get_le32( const unsigned char *p )
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static uint64_t get_le64( const unsigned char *p )
+{
+	return (uint64_t) get_le32( p ) | (uint64_t) get_le32( p+4 ) << 32;
+}
+
+/*
+The block index of a -T file (LZUF_INDEXED): after its end frame,
+an entry for each block,
+
+	data offset   8 bytes, least significant first: the block's
+	              first byte in the decoded data;
+	frame offset  8 bytes: the block's frame in the file;
+	size          4 bytes, and
+	coded size    4 bytes, as in the frame header,
+
+then the number of entries (8 bytes) and INDEX_MAGIC (8 bytes),
+so that it is found from the end of the file. A reader of a few
+bytes of the data decodes only the blocks holding them (-d -r,
+lzuf_decompress_range()). -p blocks each need the ones before,
+so they have no index.
+
+index_blocks() gives the number of entries of the index whose
+footer is f, in a file of fsize bytes, or -1 if it isn't one.
+*/
+static int64_t index_blocks( const unsigned char *f, int64_t fsize )
+{
+	int64_t n = (int64_t) get_le64( f );
+	
+	if ( memcmp( f+8, INDEX_MAGIC, 8 ) || n < 0
+		|| n > (fsize - (int64_t) sizeof(file_stamp) - INDEX_FOOTER) / INDEX_ENTRY ) return -1;
+	return n;
+}
+
+/* the entry of the last block that starts at or before data offset pos. */
+static int64_t find_block( const unsigned char *index, int64_t nblocks, int64_t pos )
+{
+	int64_t lo = 0, hi = nblocks, mid;
+	
+	while ( hi - lo > 1 ) {
+		mid = lo + (hi-lo) / 2;
+		if ( (int64_t) get_le64( index + mid * INDEX_ENTRY ) <= pos ) lo = mid;
+		else hi = mid;
+	}
+	return lo;
+}
+
+/* opens a file; "-" is stdin or stdout, in binary mode. */
+FILE *open_file( char *name, char *mode )
+{
+	FILE *f;
+	
+	if ( strcmp( name, "-" ) ) return fopen( name, mode );
+	f = ( mode[0] == 'r' ) ? stdin : stdout;
+#if defined(_WIN32)
+	_setmode( _fileno(f), _O_BINARY );
+#endif
+	return f;
+}
+
+void init_crc32( void )
+{
+	uint32_t c;
+	int i, k;
+	
+	for ( i = 0; i < 256; i++ ) {
+		c = (uint32_t) i;
+		for ( k = 0; k < 8; k++ ) c = (c & 1) ? 0xEDB88320UL ^ (c >> 1) : c >> 1;
+		crc_table[i] = c;
+	}
+}
+
+/* the CRC-32 of n more bytes; start with crc = 0. */
+uint32_t crc32( uint32_t crc, unsigned char *p, size_t n )
+{
+	crc = ~crc;
+	while ( n-- ) crc = crc_table[ (crc ^ *p++) & 0xff ] ^ (crc >> 8);
+	return ~crc;
+}
+
+/*
+Sends END_OF_STREAM, then, with LZUF_TRAILER, the data size
+(8 bytes) and CRC-32 (4 bytes) from the next byte boundary,
+least significant byte first.
+*/
+void put_end_of_stream( void )
+{
+	int i;
+	
+	put_ZERO();
+	put_ZERO();
+	put_agolomb( &run_model, END_OF_STREAM-1 );
+	if ( !(fstamp.flags & LZUF_TRAILER) ) return;
+	
+	if ( p_cnt > 0 && p_cnt < 8 ) {  /* force byte boundary. */
+		p_cnt = 7;
+		advance_buf();
+	}
+	if ( in_mapped ) data_crc = crc32( 0, in_buf, (size_t) in_end );
+	for ( i = 0; i < 8; i++ ) pfputc( (int) ((in_cur >> (i*8)) & 0xff) );
+	for ( i = 0; i < 4; i++ ) pfputc( (int) ((data_crc >> (i*8)) & 0xff) );
+}
+
+/*
+After END_OF_STREAM, checks the trailer, if any, against the
+decoded data. Returns 0 if it doesn't match.
+*/
+int get_end_of_stream( void )
+{
+	int64_t size = 0;
+	uint32_t crc = 0;
+	int i, c;
+	
+	if ( !(fstamp.flags & LZUF_TRAILER) ) return 1;
+	
+	if ( g_cnt > 0 && g_cnt < 8 ) {  /* force byte boundary. */
+		g_cnt = 7;
+		advance_gbuf();
+	}
+	for ( i = 0; i < 12; i++ ) {
+		if ( (c = gfgetc()) == EOF ) return 0;
+		if ( i < 8 ) size |= (int64_t) c << (i*8);
+		else crc |= (uint32_t) c << ((i-8)*8);
+	}
+	flush_output_view();  /* the CRC-32 of the rest of the output. */
+	return size == out_cur && crc == data_crc;
+}
+
+/*
+Maps the input file if it can, else allocates and fills the
+sliding input buffer (pipes, devices, or no mmap()).
+*/
+int open_input_view( FILE *in )
+{
+#ifdef LZUF_MMAP
+	struct stat st;
+	void *m;
+	
+	if ( fstat( fileno(in), &st ) == 0 && S_ISREG(st.st_mode)
+			&& st.st_size > 0 && (uint64_t) st.st_size <= (size_t) -1 ) {
+		m = mmap( NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fileno(in), 0 );
+		if ( m != MAP_FAILED ) {
+			#ifdef MADV_SEQUENTIAL
+			madvise( m, (size_t) st.st_size, MADV_SEQUENTIAL );
+			#endif
+			in_buf = (unsigned char *) m;
+			in_end = st.st_size;
+			in_mapped = 1;
+			in_eof = 1;
+			return 1;
+		}
+	}
+#endif
+	in_BUFSIZE = win_BUFSIZE << 2;
+	in_buf = (unsigned char *) malloc( sizeof(unsigned char) * in_BUFSIZE );
+	if ( !in_buf ) {
+		fprintf(stderr, "\nError alloc: input buffer.");
+		return 0;
+	}
+	in_end = fread( in_buf, 1, in_BUFSIZE, in );
+	in_eof = ( in_end < in_BUFSIZE );
+	if ( fstamp.flags & LZUF_TRAILER ) data_crc = crc32( data_crc, in_buf, (size_t) in_end );
+	return 1;
+}
+
+/*
+Slides the input buffer, keeping the window, and reads more
+input. Only called when not mapped and not at end of file.
+*/
+void fill_input_view( void )
+{
+	int64_t keep = in_cur - win_BUFSIZE;  /* the window starts here. */
+	size_t n, want;
+	
+	if ( keep > in_base ) {
+		memmove( in_buf, in_buf + (keep-in_base), (size_t) (in_end-keep) );
+		in_base = keep;
+	}
+	want = in_BUFSIZE - (size_t) (in_end-in_base);
+	n = fread( in_buf + (in_end-in_base), 1, want, gIN );
+	if ( fstamp.flags & LZUF_TRAILER ) data_crc = crc32( data_crc, in_buf + (in_end-in_base), n );
+	in_end += n;
+	if ( n < want ) in_eof = 1;
+}
+
+void close_input_view( void )
+{
+	if ( !in_buf ) return;
+#ifdef LZUF_MMAP
+	if ( in_mapped ) munmap( in_buf, (size_t) in_end );
+	else
+#endif
+	free( in_buf );
+	in_buf = NULL;
+}
+
+void compress( void )
+{
+	unsigned char *p;
+	unsigned int d;
+	int64_t n;
+	
+	/* compress */
+	while ( !p_mem_full ) {  /* an in-memory output may run out of room. */
+		/* keep a full look-ahead buffer. */
+		if ( !in_eof && in_cur+pat_BUFSIZE+HASH_BYTES_N > in_end ) fill_input_view();
+		if ( (n = in_end-in_cur) == 0 ) break;  /* end of input. */
+		buf_cnt = n > pat_BUFSIZE ? pat_BUFSIZE : (int) n;
+		p = in_buf + (in_cur-in_base);
+		
+		d = parse( p );
+		put_token( d, d ? dpos.len : p[0] );
+		slide( p );
+	}
+	if ( lit_cnt ) put_literals();
+}
+
+/*
+Finds the next token at p, the current position: returns the
+distance of a match of dpos.len (>= MIN_LEN) bytes, or 0 for a
+literal (dpos.len = 1).
+*/
+static inline unsigned int parse( unsigned char *p )
+{
+	if ( lit_skip ) {
+		lit_skip--;    /* a literal, without a search. */
+		dpos.len = 0;
+	}
+	else {
+		search( p );
+		if ( dpos.len < MIN_LEN ) {
+			/* the longer without a match, the more bytes are skipped. */
+			lit_skip = (++lit_miss) >> LIT_SKIP_SHIFT;
+			if ( lit_skip > LIT_SKIP_MAX ) lit_skip = LIT_SKIP_MAX;
+		}
+		else lit_miss = 0;
+	}
+	if ( dpos.len < MIN_LEN ) {
+		dpos.len = 1;
+		return 0;
+	}
+	return ((win_cnt - dpos.pos - 1) & win_MASK) + 1;
+}
+
+/* copies the parser's state to and from ps. */
+void save_parser( parse_state *ps )
+{
+	ps->in = gIN;
+	ps->in_buf = in_buf;
+	ps->in_base = in_base;
+	ps->in_end = in_end;
+	ps->in_cur = in_cur;
+	ps->in_BUFSIZE = in_BUFSIZE;
+	ps->in_mapped = in_mapped;
+	ps->in_eof = in_eof;
+	ps->win_BUFSIZE = win_BUFSIZE;
+	ps->win_MASK = win_MASK;
+	ps->hash_SHIFT = hash_SHIFT;
+	ps->pat_BUFSIZE = pat_BUFSIZE;
+	ps->far_LIST = far_LIST;
+	ps->win_cnt = win_cnt;
+	memcpy( ps->rep_dist, rep_dist, sizeof(rep_dist) );
+	ps->flags = fstamp.flags;
+	ps->data_crc = data_crc;
+	ps->lzhash = lzhash;
+	ps->lzprev = lzprev;
+	ps->lznext = lznext;
+	ps->hashp = hashp;
+}
+
+void load_parser( parse_state *ps )
+{
+	gIN = ps->in;
+	in_buf = ps->in_buf;
+	in_base = ps->in_base;
+	in_end = ps->in_end;
+	in_cur = ps->in_cur;
+	in_BUFSIZE = ps->in_BUFSIZE;
+	in_mapped = ps->in_mapped;
+	in_eof = ps->in_eof;
+	win_BUFSIZE = ps->win_BUFSIZE;
+	win_MASK = ps->win_MASK;
+	hash_SHIFT = ps->hash_SHIFT;
+	pat_BUFSIZE = ps->pat_BUFSIZE;
+	far_LIST = ps->far_LIST;
+	win_cnt = ps->win_cnt;
+	memcpy( rep_dist, ps->rep_dist, sizeof(rep_dist) );
+	fstamp.flags = ps->flags;
+	data_crc = ps->data_crc;
+	lzhash = ps->lzhash;
+	lzprev = ps->lzprev;
+	lznext = ps->lznext;
+	hashp = ps->hashp;
+}
+
+#ifdef LZUF_THREADS
+/*
+The pipeline: the parsing thread runs parse() and slide() over the
+input and fills batches of PIPE_TOKENS tokens; the coder takes the
+batches in order and runs put_token() on them. The output is the
+same as that of compress().
+
+The parsing thread has its own copy of the input view and the hash
+lists (parse_state); the coder gets back where the input ended.
+*/
+#define PIPE_TOKENS    4096
+#define PIPE_BATCHES      8
+
+typedef struct {
+	lz_token *tok[ PIPE_BATCHES ];
+	int n[ PIPE_BATCHES ];
+	int head, count;   /* the batch being coded; the batches parsed, not yet coded. */
+	int done, stop;
+	parse_state ps;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} lz_pipe;
+
+/* hands over the batch of n tokens; returns the next batch to fill, or NULL to stop. */
+static lz_token *pipe_put( lz_pipe *lp, int n )
+{
+	lz_token *t = NULL;
+	
+	pthread_mutex_lock( &lp->lock );
+	lp->n[ (lp->head + lp->count) % PIPE_BATCHES ] = n;
+	lp->count++;
+	pthread_cond_broadcast( &lp->cond );
+	while ( lp->count == PIPE_BATCHES && !lp->stop ) pthread_cond_wait( &lp->cond, &lp->lock );
+	if ( !lp->stop ) t = lp->tok[ (lp->head + lp->count) % PIPE_BATCHES ];
+	pthread_mutex_unlock( &lp->lock );
+	return t;
+}
+
+static void *parse_thread( void *arg )
+{
+	lz_pipe *lp = (lz_pipe *) arg;
+	lz_token *t = lp->tok[0];
+	unsigned char *p;
+	unsigned int d;
+	int64_t n;
+	int k = 0;
+	
+	load_parser( &lp->ps );
+	init_crc32();
+	while ( t ) {
+		if ( !in_eof && in_cur+pat_BUFSIZE+HASH_BYTES_N > in_end ) fill_input_view();
+		if ( (n = in_end-in_cur) == 0 ) break;
+		buf_cnt = n > pat_BUFSIZE ? pat_BUFSIZE : (int) n;
+		p = in_buf + (in_cur-in_base);
+		
+		d = parse( p );
+		t[k].d = d;
+		t[k].len = d ? dpos.len : p[0];
+		if ( d ) update_reps( d );  /* the coder keeps its own. */
+		slide( p );
+		if ( ++k == PIPE_TOKENS ) {
+			t = pipe_put( lp, k );
+			k = 0;
+		}
+	}
+	if ( t ) pipe_put( lp, k );
+	save_parser( &lp->ps );
+	pthread_mutex_lock( &lp->lock );
+	lp->done = 1;
+	pthread_cond_broadcast( &lp->cond );
+	pthread_mutex_unlock( &lp->lock );
+	return arg;
+}
+
+/* compress() as a pipeline; 0 if the parsing thread can't start. */
+int compress_pipeline( void )
+{
+	lz_pipe lp;
+	lz_token *t;
+	pthread_t tid;
+	int i, n, ok = 1;
+	
+	memset( &lp, 0, sizeof(lp) );
+	for ( i = 0; i < PIPE_BATCHES; i++ ) {
+		if ( (lp.tok[i] = (lz_token *) malloc( sizeof(lz_token) * PIPE_TOKENS )) == NULL ) ok = 0;
+	}
+	save_parser( &lp.ps );
+	pthread_mutex_init( &lp.lock, NULL );
+	pthread_cond_init( &lp.cond, NULL );
+	if ( ok && pthread_create( &tid, NULL, parse_thread, &lp ) != 0 ) ok = 0;
+	
+	while ( ok && !p_mem_full ) {  /* an in-memory output may run out of room. */
+		pthread_mutex_lock( &lp.lock );
+		while ( lp.count == 0 && !lp.done ) pthread_cond_wait( &lp.cond, &lp.lock );
+		n = lp.count ? lp.n[ lp.head ] : -1;
+		pthread_mutex_unlock( &lp.lock );
+		if ( n < 0 ) break;
+		
+		t = lp.tok[ lp.head ];
+		for ( i = 0; i < n; i++ ) put_token( t[i].d, t[i].len );
+		
+		pthread_mutex_lock( &lp.lock );
+		lp.head = (lp.head + 1) % PIPE_BATCHES;
+		lp.count--;
+		pthread_cond_broadcast( &lp.cond );
+		pthread_mutex_unlock( &lp.lock );
+	}
+	if ( ok ) {
+		pthread_mutex_lock( &lp.lock );
+		lp.stop = 1;  /* if the coder stopped first. */
+		pthread_cond_broadcast( &lp.cond );
+		pthread_mutex_unlock( &lp.lock );
+		pthread_join( tid, NULL );
+		load_parser( &lp.ps );
+		if ( lit_cnt ) put_literals();
+	}
+	pthread_mutex_destroy( &lp.lock );
+	pthread_cond_destroy( &lp.cond );
+	for ( i = 0; i < PIPE_BATCHES; i++ ) free( lp.tok[i] );
+	return ok;
+}
+#endif
+
+/*
+Sends the pending literal run: two 0 bits, the run length, then
+the run's bytes through MTF and FGK.
+*/
+static inline void put_literals( void )
+{
+	int i;
+	
+	put_ZERO();
+	put_ZERO();
+	put_agolomb( &run_model, lit_cnt-1 );
+	for ( i = 0; i < lit_cnt; i++ ) {
+		fgk_encode_symbol( mtf(lit_buf[i]) );
+	}
+	lit_cnt = 0;
+}
+
+/*
+Maps a regular output file at its final size, else NULL. The size
+is the file stamp's, so its space is reserved first: a corrupt size
+or a full disk then fails here, and the buffered writer is used,
+instead of leaving a sparse file or a SIGBUS on a store into the map.
+*/
+unsigned char *map_output( FILE *out, int64_t size )
+{
+#if defined( LZUF_MMAP ) && defined( LZUF_RESERVE )
+	struct stat st;
+	void *m;
+	
+	if ( size > 0 && (uint64_t) size <= (size_t) -1
+			&& fstat( fileno(out), &st ) == 0 && S_ISREG(st.st_mode) ) {
+		if ( posix_fallocate( fileno(out), 0, (off_t) size ) == 0 ) {
+			m = mmap( NULL, (size_t) size, PROT_READ | PROT_WRITE, MAP_SHARED, fileno(out), 0 );
+			if ( m != MAP_FAILED ) return (unsigned char *) m;
+		}
+		ftruncate( fileno(out), st.st_size );  /* back to its size before. */
+	}
+#endif
+	return NULL;
+}
+
+/*
+Maps the output file at its final size if it can, else allocates
+the output buffer (pipes, devices, or no mmap()).
+*/
+int open_output_view( FILE *out, int64_t size )
+{
+	out_ROOM = pat_BUFSIZE > LIT_RUN_MAX ? pat_BUFSIZE : LIT_RUN_MAX;
+	if ( (out_buf = map_output( out, size )) != NULL ) {
+		out_BUFSIZE = 0;
+		out_mapped = 1;
+		return 1;
+	}
+	out_BUFSIZE = win_BUFSIZE + out_ROOM + OUT_CHUNK + COPY_STEP;
+	out_buf = (unsigned char *) malloc( sizeof(unsigned char) * out_BUFSIZE );
+	if ( !out_buf ) {
+		fprintf(stderr, "\nError alloc: output buffer.");
+		return 0;
+	}
+	return 1;
+}
+
+/*
+Writes out the decoded bytes and slides the output buffer,
+keeping the window. Only called when not mapped.
+*/
+void flush_output_view( void )
+{
+	int64_t keep = out_cur - win_BUFSIZE;  /* the window starts here. */
+	
+	fwrite( out_buf + (out_done-out_base), 1, (size_t) (out_cur-out_done), pOUT );
+	if ( fstamp.flags & LZUF_TRAILER ) {
+		data_crc = crc32( data_crc, out_buf + (out_done-out_base), (size_t) (out_cur-out_done) );
+	}
+	out_done = out_cur;
+	if ( keep > out_base ) {
+		memmove( out_buf, out_buf + (keep-out_base), (size_t) (out_cur-keep) );
+		out_base = keep;
+	}
+}
+
+void close_output_view( void )
+{
+	if ( !out_buf ) return;
+#ifdef LZUF_MMAP
+	if ( out_mapped ) {
+		munmap( out_buf, (size_t) fstamp.file_size );
+		/* corrupt or cut short: only the bytes decoded. */
+		if ( out_cur < fstamp.file_size ) ftruncate( fileno(pOUT), (off_t) out_cur );
+	}
+	else
+#endif
+	{
+		flush_output_view();
+		free( out_buf );
+	}
+	out_buf = NULL;
+}
+
+/*
+Decodes fstamp.file_size bytes, or a stream up to its
+END_OF_STREAM, straight into the output view. A string is copied
+forward from d bytes back in the output, so a distance shorter
+than the length repeats the string. Returns 0 if the input is
+corrupt or ends too soon.
+*/
+int decompress( void )
+{
+	unsigned char *o;
+	unsigned int i, d;
+	int64_t fsize;
+	int c;
+	
+	fsize = ( fstamp.flags & LZUF_STREAM ) ? INT64_MAX : fstamp.file_size;
+	if ( fstamp.flags & LZUF_STORED ) {  /* copy the data. */
+		while ( fsize > 0 && (c = gfgetc()) != EOF ) {
+			if ( !out_mapped && out_cur+1 > out_base+out_BUFSIZE ) flush_output_view();
+			out_buf[ (out_cur++)-out_base ] = (unsigned char) c;
+			fsize--;
+		}
+		return fsize == 0;
+	}
+	while ( fsize > 0 && nfread ) {
+		/* room for the longest string. */
+		if ( !out_mapped && out_cur+out_ROOM > out_base+out_BUFSIZE ) flush_output_view();
+		o = out_buf + (out_cur-out_base);
+		
+		if ( get_bit() == 1 ){
+			/* get length. */
+			len_CODE = get_agolomb( &len_model );
+			dpos.len = len_CODE + (MIN_LEN+1);  /* actual length. */
+			
+			/* get position. */
+			d = get_distance();
+		}
+		else if ( get_bit() == 1 ){
+			dpos.len = MIN_LEN;
+			d = get_distance();
+		}
+		else {
+			/* get a run of Huffman-coded bytes and output them. */
+			i = get_agolomb( &run_model ) + 1;
+			if ( i == END_OF_STREAM && (fstamp.flags & LZUF_STREAM) ) {
+				if ( get_end_of_stream() ) fsize = 0;
+				break;
+			}
+			if ( i == SYNC_FLUSH && (fstamp.flags & LZUF_STREAM) ) {
+				/* from the earlier lzuf.c streams: out with the data so far, then skip the pad. */
+				if ( !out_mapped ) flush_output_view();
+				g_cnt = 7;
+				advance_gbuf();
+				continue;
+			}
+			if ( i > fsize || i > out_ROOM ) break;
+			fsize -= i;
+			out_cur += i;
+			while ( i-- ) {
+				*o++ = get_mtf_c(fgk_decode_symbol());
+			}
+			continue;
+		}
+		
+		/* a chunk buffer keeps the bytes from out_base, and has room for out_ROOM more. */
+		if ( d > out_cur-out_base || dpos.len > fsize || (!out_mapped && dpos.len > out_ROOM) ) break;
+		
+		/* a mapped output has no room past its end. */
+		copy_string( o, d, dpos.len, !out_mapped || fsize-dpos.len >= COPY_STEP );
+		fsize -= dpos.len;
+		out_cur += dpos.len;
+	}
+	return fsize == 0;
+}
+
+/*
+This function searches the window, the win_BUFSIZE bytes before
+the current position p in the input view, for the largest
+"string" starting at p.
+
+The function uses an "array of pointers" to doubly-linked
+lists, which contain the various occurrences or "positions" of a
+4-byte hash in the window. A list entry i is a window position
+(input offset mod win_BUFSIZE), so its string is at distance
+d = (win_cnt-i) mod win_BUFSIZE (0 means win_BUFSIZE), at p-d.
+
+Note:
+
+	We output 2 bits for a string of size MIN_LEN, so in terms of 
+	the transmitted length code, MINIMUM_MATCH_LENGTH is actually 
+	prev_LEN = (MIN_LEN+1) here, not MIN_LEN.
+
+	A match at distance d (1..win_BUFSIZE) may be longer than d;
+	its bytes past d are then the string's own first bytes, as
+	the decoder copies the string forward. The input view makes
+	this the plain compare of p[k] with (p-d)[k].
+
+	The repeat distances are tried first. They are cheaper to send,
+	so a hash list match must be at least 2 bytes longer to replace
+	one, and a repeat match of REP_GOOD_LEN bytes ends the search.
+*/
+static inline void search( unsigned char *p )
+{
+	int i, j, k, m = 0, d, rep_len = 0;
+	unsigned int rep_pos = 0;
+	unsigned char *q;
+
+	dpos.pos = 0;
+	dpos.len = 0;
+	
+	if ( buf_cnt < MIN_LEN ) return;
+	
+	/* the repeat distances. */
+	for ( k = 0; k < NUM_REPS; k++ ) {
+		if ( rep_dist[k] > in_cur ) continue;  /* before the input. */
+		if ( (j = match_len( p, rep_dist[k], 0 )) > rep_len ) {
+			rep_pos = (win_cnt - rep_dist[k]) & win_MASK;
+			rep_len = j;
+		}
+	}
+	if ( rep_len >= MIN_LEN ) {
+		dpos.pos = rep_pos;
+		dpos.len = rep_len;
+		if ( rep_len >= REP_GOOD_LEN || rep_len+1 >= buf_cnt ) return;
+		dpos.len++;  /* a hash list match must beat it by 2 bytes. */
+	}
+	
+	/* point to start of lzhash[ index ] */
+	i = lzhash[ hash(p) ];
+	
+	while ( i != LZ_NULL ) {
+		if ( (d = (win_cnt-i) & win_MASK) == 0 ) d = win_BUFSIZE;
+		q = p - d;
+		k = dpos.len;
+		do {
+			if ( p[k] != q[k] ) {
+				goto skip_search;  /* allows fast search. */
+			}
+		} while ( (--k) >= 0 );
+
+		/* then match the rest of the "suffix" string from left to right. */
+		k = match_len( p, d, dpos.len+1 );
+
+		/* greater than previous length, record it. */
+		dpos.pos = i;
+		dpos.len = k;
+		rep_len = 0;
+		
+		/* maximum match, end the search. */
+		if ( k == buf_cnt ) break;
+		
+		skip_search:
+		
+		if ( ++m == far_LIST ) break;
+
+		/* point to next occurrence of this hash index. */
+		i = lznext[i];
+	}
+	
+	/* no better match; keep the repeat match. */
+	if ( rep_len >= MIN_LEN ) dpos.len = rep_len;
+}
+
+/*
+Returns the length of the match at distance d, given that its
+first k bytes are already known to match.
+*/
+static inline int match_len( unsigned char *p, int d, int k )
+{
+	unsigned char *q = p - d;
+	
+	while ( k < buf_cnt && p[k] == q[k] ) k++;
+	return k;
+}
+
+/*
+Transmits a token: a match of len bytes at distance d, or, if
+d is 0, the literal byte len.
+
+A match sends its prefix bits first: a 1 bit if it is longer than
+MIN_LEN, then its length code; or 0 and 1 bits for exactly MIN_LEN
+bytes. Then the distance is transmitted. A literal is only added to
+the literal run, which goes out before the next match.
+*/
+static inline void put_token( unsigned int d, unsigned int len )
+{
+	if ( d == 0 ) {
+		/* add the byte to the literal run. */
+		lit_buf[ lit_cnt++ ] = (unsigned char) len;
+		if ( lit_cnt == LIT_RUN_MAX ) put_literals();
+		return;
+	}
+	
+	/* the literals before this match go first. */
+	if ( lit_cnt ) put_literals();
+	
+	/* the whole string match is encoded completely. (Oct. 19, 2008) */
+	if ( len > MIN_LEN ) { /* more than MIN_LEN match? */
+		put_ONE();            /* yes, send a 1 bit. */
+		/* suffix string length. */
+		len_CODE = len - (MIN_LEN+1);
+		put_agolomb( &len_model, len_CODE );
+	}
+	else {                  /* exactly MIN_LEN matching characters. */
+		put_ZERO();          /* send a 0 bit. */
+		put_ONE();           /* and a 1 bit. */
+	}
+	put_distance( d );
+}
+
+/*
+The "sliding" part, past the dpos.len bytes of the token at p: the
+window positions of the bytes replace the positions win_BUFSIZE
+bytes before them in the hash lists. A position is only listed if
+a 4-byte string starts there, so the hash never reads past the
+input.
+*/
+static inline void slide( unsigned char *p )
+{
+	int i, k, n;
+	
+	/* ---- "slide" the window: list the new positions. ---- */
+	n = dpos.len;
+	if ( in_end-in_cur < n+(HASH_BYTES_N-1) ) n = (int) (in_end-in_cur) - (HASH_BYTES_N-1);
+	for ( i = 0; i < dpos.len; i++ ) {
+		k = (win_cnt+i) & win_MASK;
+		if ( hashp[k] != LZ_NULL ) delete_lznode( hashp[k], k );
+		if ( i < n ) insert_lznode( hash(p+i), k );
+	}
+	
+	/* update counters. */
+	win_cnt = (win_cnt+dpos.len) & win_MASK;
+	in_cur += dpos.len;
+}
+
+/*
+Match lengths and literal run lengths are coded with a Golomb-Rice
+code whose parameter m->k follows the running mean of the recent
+values (as in LOCO-I): m->k is the least k such that
+(m->n << k) >= m->sum.
+
+A unary quotient of LEN_ESC_Q 1 bits is an escape; the rest of
+the value follows as an Exp-Golomb code of order m->k, so very
+long runs cost O(log n) bits instead of O(n).
+*/
+static inline void update_agolomb( agolomb_t *m, unsigned int n )
+{
+	m->sum += n;
+	if ( (++m->n) == LEN_RESET ) {
+		m->sum >>= 1;
+		m->n >>= 1;
+	}
+	for ( m->k = 0; (m->n << m->k) < m->sum && m->k < LEN_MAX_K; m->k++ ) ;
+}
+
+static inline void put_agolomb( agolomb_t *m, unsigned int n )
+{
+	unsigned int q = n >> m->k;
+	
+	if ( q < LEN_ESC_Q ) {
+		put_golomb( n, m->k );
+	}
+	else {
+		/* escape, then the excess as an Exp-Golomb code. */
+		for ( q = 0; q < LEN_ESC_Q; q++ ) put_ONE();
+		put_vlcode( n - (LEN_ESC_Q << m->k), m->k );
+	}
+	update_agolomb( m, n );
+}
+
+static inline unsigned int get_agolomb( agolomb_t *m )
+{
+	unsigned int n = 0;
+	
+	while ( n < LEN_ESC_Q && get_bit() ) n++;
+	if ( n < LEN_ESC_Q ) {
+		n <<= m->k;
+		if ( m->k ) n += get_nbits( m->k );
+	}
+	else n = (LEN_ESC_Q << m->k) + get_vlcode( m->k );
+	update_agolomb( m, n );
+	
+	return n;
+}
+
+/*
+A match distance d = 1..win_BUFSIZE is sent as one FGK symbol: a
+repeat code 0..NUM_REPS-1 if d is one of the recent distances in
+rep_dist[], otherwise NUM_REPS plus a log2 "slot" of v = d-1, which
+is followed by the slot's extra bits:
+
+	slots 0..3:        v = slot, no extra bits.
+	slots 2n, 2n+1:    v = 2^n..2^(n+1)-1 (n >= 2); the slot's low bit
+	                   is the bit below the MSBit of v, and the n-1
+	                   remaining bits of v follow as raw bits.
+
+Near matches thus cost a few bits instead of a full window position.
+rep_dist[] is kept in most-recently-used order by both coders.
+*/
+static inline void update_reps( unsigned int d )
+{
+	int r;
+	
+	for ( r = 0; r < NUM_REPS-1 && rep_dist[r] != d; r++ ) ;
+	for ( ; r > 0; r-- ) rep_dist[r] = rep_dist[r-1];
+	rep_dist[0] = d;
+}
+
+static inline void put_distance( unsigned int d )
+{
+	unsigned int nb, v = d-1;
+	
+	for ( nb = 0; nb < NUM_REPS; nb++ ) {
+		if ( rep_dist[nb] == d ) {
+			fgk_encode_symbol( nb );
+			update_reps( d );
+			return;
+		}
+	}
+	if ( v < 4 ) {
+		fgk_encode_symbol( NUM_REPS + v );
+	}
+	else {
+		for ( nb = 2; (v >> (nb+1)) != 0; nb++ ) ;
+		fgk_encode_symbol( NUM_REPS + ((nb<<1) | ((v >> (nb-1)) & 1)) );
+		put_nbits( v, nb-1 );
+	}
+	update_reps( d );
+}
+
+static inline unsigned int get_distance( void )
+{
+	unsigned int slot = fgk_decode_symbol(), nb, d;
+	
+	if ( slot < NUM_REPS ) d = rep_dist[slot];
+	else if ( (slot -= NUM_REPS) < 4 ) d = slot+1;
+	else {
+		nb = slot >> 1;
+		if ( nb >= num_POS_BITS ) return (unsigned int) -1;  /* past win_BUFSIZE: corrupt. */
+		d = (((2 | (slot & 1)) << (nb-1)) | get_nbits( nb-1 )) + 1;
+	}
+	update_reps( d );
+	
+	return d;
+}
+
+/*
+Copies the len-byte string at distance d back to o, forward, so
+that a string longer than its distance repeats its first d bytes.
+
+With d >= COPY_STEP every step reads only bytes already written,
+so the string goes COPY_STEP bytes at a time; if wild, up to
+COPY_STEP-1 bytes past the string may be written. A shorter
+period is replicated by doubling: after each copy, the bytes
+from q to o repeat with twice the period.
+*/
+static inline void copy_string( unsigned char *o, unsigned int d, unsigned int len, int wild )
+{
+	unsigned char *q = o - d, *e;
+	
+	if ( d >= COPY_STEP && wild ) {
+		e = o + len;
+		do {
+			memcpy( o, q, COPY_STEP );
+			o += COPY_STEP;
+			q += COPY_STEP;
+		} while ( o < e );
+	}
+	else if ( d == 1 ) {
+		memset( o, *q, len );
+	}
+	else {
+		while ( len > d ) {
+			memcpy( o, q, d );
+			o += d;
+			len -= d;
+			d <<= 1;
+		}
+		memcpy( o, q, len );
+	}
+}
@@ -1,9 +1,12 @@
 /*
-	Filename:   lzhhfx2.c (Oct. 22, 2008) .(4/11/2010)(2/24/2022)(2/16/2023)
+	Filename:   lzhhfx2.c (Oct. 22, 2008) .(4/11/2010)(2/24/2022)(2/16/2023)(10/16/2026)
 	Encoder:    lzhhf2.c
 	
 	Decompression in LZ77/LZSS is faster since you just have to extract
 	the bytes from the window buffer using the pos and len variables.
+	
+	Strings are moved in the window with memmove(), through pattern[] only where
+	they wrap around its end, and written out whole with pfwrite(). (10/16/2026)
 */
 #include <stdio.h>
 #include <stdlib.h>
@@ -50,11 +53,12 @@ uchar *pattern;  /* the "look-ahead" buffer (LAB). */
 int win_cnt = 0, len_CODE = 0;
 
 void copyright( void );
+static inline unsigned char *copy_window( unsigned char *w, unsigned char *s, unsigned int pos, unsigned int len );
 
 int main( int argc, char *argv[] )
 {	
 	int64_t fsize = 0;
-	unsigned int i, k;
+	unsigned int k;
 	file_stamp fstamp;
 
 	if ( argc != 3 ) {
@@ -127,21 +131,8 @@ int main( int argc, char *argv[] )
 			dpos.pos = (k << hash_SHIFT) | get_nbits( hash_SHIFT );
 			dpos.len = len_CODE + (MIN_LEN+1);  /* actual length. */
 			
-			/* if its a match, then "slide" the window buffer. */
-			i = dpos.len;
-			while ( i-- ) {
-				/* copy byte. */
-				pattern[i] = win_buf[ (dpos.pos+i) & win_MASK ];
-			}
-			i = dpos.len;
-			while ( i-- ) {
-				win_buf[ (win_cnt+i) & win_MASK ] = pattern[ i ];
-			}
-			/* output string. */
-			i = 0;
-			while ( i < dpos.len ) {
-				pfputc( pattern[i++] );
-			}
+			/* if its a match, then "slide" the window buffer, and output the string. */
+			pfwrite( copy_window( win_buf, pattern, dpos.pos, dpos.len ), dpos.len );
 			fsize -= dpos.len;
 			win_cnt = (win_cnt + dpos.len) & win_MASK;
 		}
@@ -164,21 +155,8 @@ int main( int argc, char *argv[] )
 			dpos.pos = (k << hash_SHIFT) | get_nbits( hash_SHIFT );
 			dpos.len = MIN_LEN;
 			
-			/* if its a match, then "slide" the window buffer. */
-			i = dpos.len;
-			while ( i-- ) {
-				/* copy byte. */
-				pattern[i] = win_buf[ (dpos.pos+i) & win_MASK ];
-			}
-			i = dpos.len;
-			while ( i-- ) {
-				win_buf[ (win_cnt+i) & win_MASK ] = pattern[ i ];
-			}
-			/* output string. */
-			i = 0;
-			while ( i < dpos.len ) {
-				pfputc( pattern[i++] );
-			}
+			/* if its a match, then "slide" the window buffer, and output the string. */
+			pfwrite( copy_window( win_buf, pattern, dpos.pos, dpos.len ), dpos.len );
 			fsize -= dpos.len;
 			win_cnt = (win_cnt + dpos.len) & win_MASK;
 		
@@ -209,3 +187,33 @@ void copyright( void )
 {
 	fprintf(stderr, "\n\n Written by: Gerald Tamayo, 2008/2022\n");
 }
+
+/*
+Copies the len-byte string (len <= win_BUFSIZE) at window position
+pos to win_cnt, with the bytes the window had before the copy, and
+returns where the string now is in one piece. If neither the string
+nor its copy wraps around the end of the ring, it is moved in place
+with memmove() (wide, and with the same result where the two
+overlap); else it goes through s, in two parts where it wraps.
+*/
+static inline unsigned char *copy_window( unsigned char *w, unsigned char *s, unsigned int pos, unsigned int len )
+{
+	unsigned int n = win_BUFSIZE - pos;
+	
+	if ( len <= n && len <= win_BUFSIZE - win_cnt ) {
+		memmove( w+win_cnt, w+pos, len );
+		return w+win_cnt;
+	}
+	if ( len <= n ) memcpy( s, w+pos, len );
+	else {
+		memcpy( s, w+pos, n );
+		memcpy( s+n, w, len-n );
+	}
+	n = win_BUFSIZE - win_cnt;
+	if ( len <= n ) memcpy( w+win_cnt, s, len );
+	else {
+		memcpy( w+win_cnt, s, n );
+		memcpy( w, s+n, len-n );
+	}
+	return s;
+}
@@ -0,0 +1,691 @@
+/*
+	Filename:   LZUF.C
+	Author:     Gerald Tamayo
+	Date:       10/16/2026
+	
+	In-memory LZUF5 compression: the lzhhf5 coder and decoder
+	run on the caller's buffers, with no files and no stdio.
+	
+	The output is an LZUF5 file image (file stamp + data), so
+	"lzhhf5 -d" decodes it too. Data that doesn't compress is
+	stored as is, so the output is never more than
+	lzuf_compress_bound() bytes.
+	
+	Thread-safe: the codec's state is per thread (GT_REENTRANT),
+	so each thread runs its own coder or decoder. Each call runs
+	its codec from start to end and keeps none of it, so calls
+	and streams on a thread can be interleaved freely.
+	
+	lzuf_compress_init() and lzuf_decompress_init() open an
+	incremental stream: the data goes through lzuf_step() a piece
+	at a time, in bounded memory, and is coded as the
+	primed blocks of "lzhhf5 -T -p". With LZUF_SYNC_FLUSH, the
+	coder's output so far decodes to all of its input so far (for
+	logs and other live data).
+	
+	lzuf_decompress_range() reads a slice of the data of a file
+	coded with "lzhhf5 -T" (without -p), e.g. mapped, decoding
+	only the blocks that hold it. lzuf_cache_range() does too, but
+	keeps the blocks it decodes in an lzuf_cache, shared by all
+	of the threads that read through it, up to a memory budget.
+*/
+#define LZUF_LIB
+#define GT_REENTRANT
+#include <pthread.h>
+#include "lzhhf5.c"
+#include "lzuf.h"
+
+/* the window and list sizes of params, or 0 if out of range. */
+static int get_params( const lzuf_params *params, int *bits, int *list_bits )
+{
+	*bits = NUM_POS_BITS;
+	*list_bits = FAR_LIST_BITS;
+	if ( params ) {
+		if ( params->window_bits ) *bits = params->window_bits;
+		if ( params->list_bits ) *list_bits = params->list_bits;
+	}
+	return *bits >= 12 && *bits <= 20 && *list_bits >= 1 && *list_bits <= 12;
+}
+
+size_t lzuf_compress_bound( size_t src_size )
+{
+	return src_size + sizeof(file_stamp);
+}
+
+size_t lzuf_compress( const void *src, size_t src_size,
+	void *dst, size_t dst_cap, const lzuf_params *params )
+{
+	unsigned char *out = (unsigned char *) dst;
+	file_stamp fs;
+	int bits, list_bits;
+	size_t room, n = LZUF_ERROR;
+	
+	if ( !get_params( params, &bits, &list_bits ) ) return LZUF_ERROR;
+	if ( dst_cap < sizeof(file_stamp) ) return LZUF_ERROR;
+	
+	/* a window larger than the input finds nothing more. */
+	while ( bits > 12 && ((size_t) 1 << (bits-1)) >= src_size ) bits--;
+	
+	memset( &fs, 0, sizeof(file_stamp) );
+	strcpy( fs.algorithm, "LZUF5" );
+	fs.num_pos_bits = bits;
+	fs.file_size = (int64_t) src_size;
+	
+	/* no more than stored data. */
+	room = dst_cap < lzuf_compress_bound( src_size ) ? dst_cap : lzuf_compress_bound( src_size );
+	
+	n = compress_block( (const unsigned char *) src, src_size, out + sizeof(file_stamp),
+		room - sizeof(file_stamp), bits, list_bits, 0 );
+	if ( n ) n += sizeof(file_stamp);
+	else if ( dst_cap >= lzuf_compress_bound( src_size ) ) {
+		fs.flags = LZUF_STORED;
+		memcpy( out + sizeof(file_stamp), src, src_size );
+		n = lzuf_compress_bound( src_size );
+	}
+	else n = LZUF_ERROR;
+	if ( n != LZUF_ERROR ) memcpy( out, &fs, sizeof(file_stamp) );
+	return n;
+}
+
+/* the size of the data in a compressed buffer, or LZUF_ERROR. */
+size_t lzuf_decompressed_size( const void *src, size_t src_size )
+{
+	file_stamp fs;
+	
+	if ( src_size < sizeof(file_stamp) ) return LZUF_ERROR;
+	memcpy( &fs, src, sizeof(file_stamp) );
+	if ( strncmp( fs.algorithm, "LZUF5", 8 ) ) return LZUF_ERROR;
+	if ( fs.num_pos_bits < 12 || fs.num_pos_bits > 20 ) return LZUF_ERROR;
+	
+	/* a stream has no size up front; an archive has files, not one size. */
+	if ( (fs.flags & (LZUF_STREAM | LZUF_ARCHIVE)) || fs.file_size < 0 ) return LZUF_ERROR;
+	if ( (uint64_t) fs.file_size > (size_t) -1 ) return LZUF_ERROR;
+	return (size_t) fs.file_size;
+}
+
+/* decodes the frames of a -T image (LZUF_BLOCKS), n bytes of data in all, into dst. */
+static size_t decompress_frames( const unsigned char *p, size_t size,
+	unsigned char *dst, size_t n, int bits, int primed )
+{
+	size_t pos = sizeof(file_stamp), total = 0, bn, cn, prime;
+	
+	while ( size - pos >= 8 ) {
+		bn = get_le32( p+pos );
+		cn = get_le32( p+pos+4 );
+		pos += 8;
+		if ( bn == 0 ) return cn == 0 && total == n ? total : LZUF_ERROR;  /* the end. */
+		if ( cn == 0 || cn > bn || bn > n - total || cn > size - pos ) return LZUF_ERROR;
+		prime = 0;  /* -p: the window of output before the block. */
+		if ( primed ) prime = total < ((size_t) 1 << bits) ? total : (size_t) 1 << bits;
+		if ( cn == bn ) memcpy( dst + total, p + pos, bn );
+		else if ( !decompress_block( p + pos, cn, dst + total, bn, bits, prime ) ) return LZUF_ERROR;
+		pos += cn;
+		total += bn;
+	}
+	return LZUF_ERROR;
+}
+
+size_t lzuf_decompress( const void *src, size_t src_size,
+	void *dst, size_t dst_cap )
+{
+	file_stamp fs;
+	size_t n = LZUF_ERROR;
+	
+	if ( (n = lzuf_decompressed_size( src, src_size )) == LZUF_ERROR ) return n;
+	if ( n > dst_cap ) return LZUF_ERROR;
+	memcpy( &fs, src, sizeof(file_stamp) );
+	if ( fs.flags & LZUF_BLOCKS ) {
+		return decompress_frames( (const unsigned char *) src, src_size, (unsigned char *) dst, n,
+			fs.num_pos_bits, (fs.flags & LZUF_PRIMED) != 0 );
+	}
+	
+	n = LZUF_ERROR;
+	if ( !init_codec( fs.num_pos_bits, FAR_LIST_BITS ) ) goto halt_lib;
+	fstamp = fs;
+	
+	/* the decoder's output view is the destination, at full size. */
+	out_buf = (unsigned char *) dst;
+	out_mapped = 1;
+	init_get_memory( (unsigned char *) src + sizeof(file_stamp), src_size - sizeof(file_stamp) );
+	if ( decompress() ) n = (size_t) out_cur;
+	
+	halt_lib:
+	
+	free_codec();
+	return n;
+}
+
+/* ---- random access ---- */
+
+/*
+An lzuf_cache keeps the blocks last decoded by lzuf_cache_range(),
+up to budget bytes of them, for all of the threads that read
+through it. A block is known by its file image (the src pointer)
+and its frame offset. The blocks are in a hash table and in a
+list, most recently used first; a new block pushes out the least
+recently used ones that no reader is copying from. A block being
+decoded is in the table too, so a reader that wants it waits for
+it instead of decoding it again.
+*/
+#define CACHE_BUCKETS  1024
+
+typedef struct cache_block {
+	const unsigned char *file;   /* the image, */
+	int64_t coff;                /* and the block's frame in it. */
+	unsigned char *data;
+	size_t n;
+	int refs;          /* the readers copying from it, or waiting for it. */
+	int ready, dead;   /* decoded; out of the cache, freed when refs is 0. */
+	struct cache_block *prev, *next;  /* the list, most recent first. */
+	struct cache_block *chain;        /* the next in its bucket. */
+} cache_block;
+
+typedef struct {
+	size_t used;       /* bytes of blocks in the cache. */
+	cache_block *head, *tail;
+	cache_block *bucket[ CACHE_BUCKETS ];
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+} cache_state;
+
+static cache_block **cache_slot( cache_state *cs, const unsigned char *file, int64_t coff )
+{
+	uint64_t h = ((uint64_t) (uintptr_t) file ^ (uint64_t) coff) * 0x9E3779B97F4A7C15ULL;
+	
+	return &cs->bucket[ (h >> 32) & (CACHE_BUCKETS-1) ];
+}
+
+/* takes b out of the table and the list; freed now or by its last reader. */
+static void drop_block( cache_state *cs, cache_block *b )
+{
+	cache_block **q = cache_slot( cs, b->file, b->coff );
+	
+	while ( *q != b ) q = &(*q)->chain;
+	*q = b->chain;
+	if ( b->prev ) b->prev->next = b->next;
+	else cs->head = b->next;
+	if ( b->next ) b->next->prev = b->prev;
+	else cs->tail = b->prev;
+	cs->used -= b->n;
+	b->dead = 1;
+	if ( b->refs == 0 ) {
+		free( b->data );
+		free( b );
+	}
+}
+
+/* pushes out the least recently used blocks not in use, down to the budget. */
+static void trim_cache( lzuf_cache *c, cache_state *cs )
+{
+	cache_block *b = cs->tail, *prev;
+	
+	while ( b && cs->used > c->budget ) {
+		prev = b->prev;
+		if ( b->refs == 0 ) drop_block( cs, b );
+		b = prev;
+	}
+}
+
+/* the cached block of frame f (at coff in file), decoded if not yet; NULL if corrupt. */
+static cache_block *get_block( lzuf_cache *c, const unsigned char *file, int64_t coff,
+	const unsigned char *f, size_t cn, size_t n, int bits )
+{
+	cache_state *cs = (cache_state *) c->state;
+	cache_block **q, *b;
+	int ok;
+	
+	pthread_mutex_lock( &cs->lock );
+	q = cache_slot( cs, file, coff );
+	for ( b = *q; b && (b->file != file || b->coff != coff); b = b->chain ) ;
+	if ( b ) {
+		b->refs++;
+		c->hits++;
+		if ( b != cs->head ) {  /* to the front. */
+			b->prev->next = b->next;
+			if ( b->next ) b->next->prev = b->prev;
+			else cs->tail = b->prev;
+			b->prev = NULL;
+			b->next = cs->head;
+			cs->head->prev = b;
+			cs->head = b;
+		}
+		while ( !b->ready && !b->dead ) pthread_cond_wait( &cs->cond, &cs->lock );
+	}
+	else if ( (b = (cache_block *) calloc( 1, sizeof(cache_block) )) != NULL ) {
+		b->file = file;
+		b->coff = coff;
+		b->n = n;
+		b->refs = 1;
+		b->chain = *q;
+		*q = b;
+		b->next = cs->head;
+		if ( cs->head ) cs->head->prev = b;
+		else cs->tail = b;
+		cs->head = b;
+		cs->used += n;
+		c->misses++;
+		trim_cache( c, cs );
+		pthread_mutex_unlock( &cs->lock );
+		
+		ok = (b->data = (unsigned char *) malloc( n )) != NULL
+			&& decompress_block( f, cn, b->data, n, bits, 0 );
+		
+		pthread_mutex_lock( &cs->lock );
+		if ( ok ) b->ready = 1;
+		else if ( !b->dead ) drop_block( cs, b );  /* not forgotten already. */
+		pthread_cond_broadcast( &cs->cond );
+	}
+	if ( b && b->dead && !b->ready ) {  /* corrupt, or no memory. */
+		if ( --b->refs == 0 ) {
+			free( b->data );
+			free( b );
+		}
+		b = NULL;
+	}
+	pthread_mutex_unlock( &cs->lock );
+	return b;
+}
+
+/* a reader is done with b. */
+static void put_block( lzuf_cache *c, cache_block *b )
+{
+	cache_state *cs = (cache_state *) c->state;
+	
+	pthread_mutex_lock( &cs->lock );
+	if ( --b->refs == 0 && b->dead ) {
+		free( b->data );
+		free( b );
+	}
+	else trim_cache( c, cs );
+	pthread_mutex_unlock( &cs->lock );
+}
+
+/* lzuf_decompress_range(), through the cache c if not NULL. */
+static size_t read_range( lzuf_cache *c, const void *src, size_t src_size,
+	int64_t offset, void *dst, size_t len )
+{
+	const unsigned char *p = (const unsigned char *) src, *index, *e, *f;
+	unsigned char *out = (unsigned char *) dst, *buf = NULL;
+	cache_block *b;
+	file_stamp fs;
+	int64_t nblocks, k, skip, coff;
+	size_t n, cn, take, done = 0, buf_cap = 0;
+	
+	if ( src_size < sizeof(file_stamp) + INDEX_FOOTER || offset < 0 ) return LZUF_ERROR;
+	memcpy( &fs, src, sizeof(file_stamp) );
+	if ( strncmp( fs.algorithm, "LZUF5", 8 ) || !(fs.flags & LZUF_INDEXED) ) return LZUF_ERROR;
+	if ( fs.num_pos_bits < 12 || fs.num_pos_bits > 20 ) return LZUF_ERROR;
+	if ( (nblocks = index_blocks( p + src_size - INDEX_FOOTER, (int64_t) src_size )) < 0 ) return LZUF_ERROR;
+	index = p + src_size - INDEX_FOOTER - nblocks * INDEX_ENTRY;
+	
+	for ( k = find_block( index, nblocks, offset ); k < nblocks && done < len; k++ ) {
+		e = index + k * INDEX_ENTRY;
+		n = get_le32( e+16 );
+		cn = get_le32( e+20 );
+		coff = (int64_t) get_le64( e+8 );
+		skip = offset + (int64_t) done - (int64_t) get_le64( e );
+		if ( n == 0 || cn == 0 || cn > n || skip < 0 || coff < (int64_t) sizeof(file_stamp)
+			|| coff > (int64_t) (index - p) - 8 - (int64_t) cn ) goto halt_lib;
+		if ( skip >= (int64_t) n ) continue;  /* past the end of the data. */
+		f = p + coff;  /* its frame. */
+		if ( memcmp( f, e+16, 8 ) ) goto halt_lib;
+		take = n - (size_t) skip < len - done ? n - (size_t) skip : len - done;
+		if ( cn == n ) memcpy( out + done, f + 8 + skip, take );
+		else if ( c ) {
+			if ( (b = get_block( c, p, coff, f + 8, cn, n, fs.num_pos_bits )) == NULL ) goto halt_lib;
+			memcpy( out + done, b->data + skip, take );
+			put_block( c, b );
+		}
+		else if ( take == n ) {  /* the whole block, in place. */
+			if ( !decompress_block( f + 8, cn, out + done, n, fs.num_pos_bits, 0 ) ) goto halt_lib;
+		}
+		else {
+			if ( n > buf_cap ) {
+				free( buf );
+				buf_cap = (buf = (unsigned char *) malloc( n )) != NULL ? n : 0;
+				if ( !buf ) goto halt_lib;
+			}
+			if ( !decompress_block( f + 8, cn, buf, n, fs.num_pos_bits, 0 ) ) goto halt_lib;
+			memcpy( out + done, buf + skip, take );
+		}
+		done += take;
+	}
+	free( buf );
+	return done;
+	
+	halt_lib:
+	
+	free( buf );
+	return LZUF_ERROR;
+}
+
+/*
+Decodes up to len bytes of the data from offset into dst, from the
+blocks of an indexed -T file image (LZUF_INDEXED). Returns the
+bytes decoded, fewer at the end of the data, or LZUF_ERROR.
+*/
+size_t lzuf_decompress_range( const void *src, size_t src_size,
+	int64_t offset, void *dst, size_t len )
+{
+	return read_range( NULL, src, src_size, offset, dst, len );
+}
+
+int lzuf_cache_init( lzuf_cache *c, size_t budget )
+{
+	cache_state *cs = (cache_state *) calloc( 1, sizeof(cache_state) );
+	
+	c->state = cs;
+	c->budget = budget;
+	c->hits = c->misses = 0;
+	if ( !cs ) return LZUF_MEM_ERROR;
+	pthread_mutex_init( &cs->lock, NULL );
+	pthread_cond_init( &cs->cond, NULL );
+	return LZUF_OK;
+}
+
+/* lzuf_decompress_range(), with the blocks decoded kept in c. */
+size_t lzuf_cache_range( lzuf_cache *c, const void *src, size_t src_size,
+	int64_t offset, void *dst, size_t len )
+{
+	if ( !c->state ) return LZUF_ERROR;
+	return read_range( c, src, src_size, offset, dst, len );
+}
+
+/* drops the blocks of src, e.g. before it is unmapped; none of them may be in use. */
+int lzuf_cache_forget( lzuf_cache *c, const void *src )
+{
+	cache_state *cs = (cache_state *) c->state;
+	cache_block *b, *next;
+	
+	if ( !cs ) return LZUF_PARAM_ERROR;
+	pthread_mutex_lock( &cs->lock );
+	for ( b = cs->head; b; b = next ) {
+		next = b->next;
+		if ( b->file == (const unsigned char *) src ) drop_block( cs, b );
+	}
+	pthread_mutex_unlock( &cs->lock );
+	return LZUF_OK;
+}
+
+/* frees the cache; no reader may be in it. */
+int lzuf_cache_end( lzuf_cache *c )
+{
+	cache_state *cs = (cache_state *) c->state;
+	
+	if ( !cs ) return LZUF_PARAM_ERROR;
+	while ( cs->head ) drop_block( cs, cs->head );
+	pthread_mutex_destroy( &cs->lock );
+	pthread_cond_destroy( &cs->cond );
+	free( cs );
+	c->state = NULL;
+	return LZUF_OK;
+}
+
+/* ---- incremental streams ---- */
+
+/*
+A stream is the frames of "lzhhf5 -T -p" to a pipe (LZUF_STREAM,
+LZUF_BLOCKS and LZUF_PRIMED): the input is cut into blocks of
+STREAM_BLOCK bytes, each primed with the window before it, and a
+flush point ends a block early. A block is coded, or decoded,
+whole by compress_block() or decompress_block() within one
+lzuf_step(), so no codec state is kept from step to step: a
+stream holds only the window, the block and its frame.
+*/
+#define STREAM_BLOCK( bits )  ((size_t) 1 << ((bits) < 16 ? 18 : (bits)+2))
+
+enum { ST_STAMP, ST_HEADER, ST_DATA, ST_OUT, ST_END };
+
+typedef struct {
+	int decoding;
+	int bits, list_bits;
+	int flush;         /* LZUF_FINISH, once passed. */
+	int status;        /* LZUF_OK, then LZUF_STREAM_END or an error. */
+	unsigned char *buf;  /* the window (pre bytes of room), then the block. */
+	size_t pre, cap;   /* the room before the block, and for it. */
+	size_t prime, n;   /* the bytes of window before the block; in the block. */
+	unsigned char *out;  /* coding: the frames not out yet; decoding: the frame's coded block. */
+	size_t out_cap, out_len, out_pos;
+	int stage;         /* decoding: what comes next (ST_...). */
+	file_stamp fs;
+	unsigned char h[8];  /* the frame header. */
+	size_t got;        /* the bytes of the stamp, header or coded block in so far. */
+	size_t cn;         /* the coded size of the frame's block. */
+	int64_t total;     /* the data in the blocks done. */
+} lzuf_state;
+
+/* copies up to n bytes of next_in to p; returns how many. */
+static size_t take_input( lzuf_stream *s, unsigned char *p, size_t n )
+{
+	if ( n > s->avail_in ) n = s->avail_in;
+	if ( n == 0 ) return 0;
+	memcpy( p, s->next_in, n );
+	s->next_in += n;
+	s->avail_in -= n;
+	s->total_in += n;
+	return n;
+}
+
+/* copies what fits of the bytes from p + *pos up to p + len to next_out. */
+static void give_output( lzuf_stream *s, const unsigned char *p, size_t *pos, size_t len )
+{
+	size_t n = len - *pos < s->avail_out ? len - *pos : s->avail_out;
+	
+	if ( n == 0 ) return;
+	memcpy( s->next_out, p + *pos, n );
+	s->next_out += n;
+	s->avail_out -= n;
+	s->total_out += n;
+	*pos += n;
+}
+
+/* the block done: its last window (with the one before) primes the next. */
+static void slide_block( lzuf_state *st )
+{
+	unsigned char *b = st->buf + st->pre;
+	size_t k = st->prime + st->n < st->pre ? st->prime + st->n : st->pre;
+	
+	memmove( b - k, b + st->n - k, k );
+	st->prime = k;
+	st->total += st->n;
+	st->n = 0;
+}
+
+/* appends the block as a frame to the output, coded if it shrinks; n == 0 is the end frame. */
+static void put_frame( lzuf_state *st )
+{
+	unsigned char *f = st->out + st->out_len;
+	size_t cn = 0;
+	
+	if ( st->n > 1 ) {
+		cn = compress_block( st->buf + st->pre, st->n, f+8, st->n-1,
+			st->bits, st->list_bits, st->prime );
+	}
+	if ( cn == 0 ) memcpy( f+8, st->buf + st->pre, cn = st->n );  /* stored. */
+	put_le32( f, (uint32_t) st->n );
+	put_le32( f+4, (uint32_t) cn );
+	st->out_len += 8 + cn;
+	slide_block( st );
+}
+
+static int stream_compress( lzuf_stream *s, lzuf_state *st )
+{
+	while ( 1 ) {
+		give_output( s, st->out, &st->out_pos, st->out_len );
+		if ( st->out_pos < st->out_len ) return LZUF_OK;  /* needs more room. */
+		st->out_pos = st->out_len = 0;
+		if ( st->stage == ST_END ) return LZUF_STREAM_END;
+		
+		st->n += take_input( s, st->buf + st->pre + st->n, st->cap - st->n );
+		if ( st->n == st->cap ) put_frame( st );
+		else if ( st->flush == LZUF_FINISH ) {
+			if ( st->n ) put_frame( st );
+			put_frame( st );  /* the end frame. */
+			st->stage = ST_END;
+		}
+		else if ( st->flush == LZUF_SYNC_FLUSH && st->n ) put_frame( st );
+		else return LZUF_OK;  /* needs more input. */
+	}
+}
+
+/* room for a block of n bytes after the window, and for cn coded bytes. */
+static int frame_room( lzuf_state *st, size_t n, size_t cn )
+{
+	unsigned char *p;
+	
+	if ( n > st->cap ) {
+		if ( (p = (unsigned char *) realloc( st->buf, st->pre + n )) == NULL ) return 0;
+		st->buf = p;
+		st->cap = n;
+	}
+	if ( cn > st->out_cap ) {
+		free( st->out );
+		st->out_cap = (st->out = (unsigned char *) malloc( cn )) != NULL ? cn : 0;
+		if ( !st->out ) return 0;
+	}
+	return 1;
+}
+
+/* checks the stamp: only the frames of LZUF_BLOCKS are decoded a block at a time. */
+static int stream_stamp( lzuf_state *st )
+{
+	file_stamp *fs = &st->fs;
+	
+	if ( strncmp( fs->algorithm, "LZUF5", 8 ) || fs->num_pos_bits < 12 || fs->num_pos_bits > 20
+		|| (!(fs->flags & LZUF_STREAM) && fs->file_size < 0) ) return LZUF_DATA_ERROR;
+	if ( !(fs->flags & LZUF_BLOCKS) || (fs->flags & LZUF_ARCHIVE) ) return LZUF_PARAM_ERROR;
+	st->bits = fs->num_pos_bits;
+	if ( fs->flags & LZUF_PRIMED ) st->pre = (size_t) 1 << st->bits;
+	if ( (st->buf = (unsigned char *) malloc( st->pre )) == NULL && st->pre ) return LZUF_MEM_ERROR;
+	return LZUF_OK;
+}
+
+/* checks the frame header; 0 if corrupt. */
+static int stream_frame( lzuf_state *st )
+{
+	int64_t left = (st->fs.flags & LZUF_STREAM) ? INT64_MAX : st->fs.file_size - st->total;
+	
+	st->n = get_le32( st->h );
+	st->cn = get_le32( st->h+4 );
+	if ( st->n == 0 ) return st->cn == 0 && ((st->fs.flags & LZUF_STREAM) || left == 0);  /* the end. */
+	return st->n <= BLOCK_MAX && (int64_t) st->n <= left && st->cn > 0 && st->cn <= st->n;
+}
+
+static int stream_decompress( lzuf_stream *s, lzuf_state *st )
+{
+	unsigned char *p;
+	size_t len;
+	int status;
+	
+	while ( 1 ) {
+		if ( st->stage == ST_OUT ) {
+			give_output( s, st->buf + st->pre, &st->out_pos, st->n );
+			if ( st->out_pos < st->n ) return LZUF_OK;  /* needs more room. */
+			st->out_pos = 0;
+			slide_block( st );
+			st->stage = ST_HEADER;
+		}
+		if ( st->stage == ST_END ) return LZUF_STREAM_END;
+		
+		/* the stamp, a frame header or a coded block; the rest of next_in is left. */
+		if ( st->stage == ST_STAMP ) p = (unsigned char *) &st->fs, len = sizeof(file_stamp);
+		else if ( st->stage == ST_HEADER ) p = st->h, len = 8;
+		else p = st->out, len = st->cn;
+		st->got += take_input( s, p + st->got, len - st->got );
+		if ( st->got < len ) return st->flush == LZUF_FINISH ? LZUF_DATA_ERROR : LZUF_OK;
+		st->got = 0;
+		
+		if ( st->stage == ST_STAMP ) {
+			if ( (status = stream_stamp( st )) != LZUF_OK ) return status;
+			st->stage = ST_HEADER;
+		}
+		else if ( st->stage == ST_HEADER ) {
+			if ( !stream_frame( st ) ) return LZUF_DATA_ERROR;
+			if ( st->n == 0 ) st->stage = ST_END;
+			else if ( !frame_room( st, st->n, st->cn ) ) return LZUF_MEM_ERROR;
+			else st->stage = ST_DATA;
+		}
+		else {
+			if ( st->cn == st->n ) memcpy( st->buf + st->pre, st->out, st->n );
+			else if ( !decompress_block( st->out, st->cn, st->buf + st->pre, st->n,
+				st->bits, st->prime ) ) return LZUF_DATA_ERROR;
+			st->stage = ST_OUT;
+		}
+	}
+}
+
+int lzuf_compress_init( lzuf_stream *s, const lzuf_params *params )
+{
+	lzuf_state *st;
+	file_stamp fs;
+	int bits, list_bits;
+	
+	s->state = NULL;
+	s->total_in = s->total_out = 0;
+	if ( !get_params( params, &bits, &list_bits ) ) return LZUF_PARAM_ERROR;
+	if ( (st = (lzuf_state *) calloc( 1, sizeof(lzuf_state) )) == NULL ) return LZUF_MEM_ERROR;
+	st->bits = bits;
+	st->list_bits = list_bits;
+	st->pre = (size_t) 1 << bits;
+	st->cap = STREAM_BLOCK( bits );
+	st->out_cap = 16 + st->cap;  /* a frame, stored, and the end frame. */
+	st->buf = (unsigned char *) malloc( st->pre + st->cap );
+	st->out = (unsigned char *) malloc( st->out_cap );
+	if ( !st->buf || !st->out ) {
+		free( st->buf );
+		free( st->out );
+		free( st );
+		return LZUF_MEM_ERROR;
+	}
+	memset( &fs, 0, sizeof(file_stamp) );
+	strcpy( fs.algorithm, "LZUF5" );
+	fs.num_pos_bits = bits;
+	fs.flags = LZUF_STREAM | LZUF_BLOCKS | LZUF_PRIMED;
+	memcpy( st->out, &fs, sizeof(file_stamp) );
+	st->out_len = sizeof(file_stamp);
+	s->state = st;
+	return LZUF_OK;
+}
+
+int lzuf_decompress_init( lzuf_stream *s )
+{
+	lzuf_state *st = (lzuf_state *) calloc( 1, sizeof(lzuf_state) );
+	
+	s->total_in = s->total_out = 0;
+	s->state = st;
+	if ( !st ) return LZUF_MEM_ERROR;
+	st->decoding = 1;
+	return LZUF_OK;
+}
+
+/*
+Codes or decodes until it needs more input (avail_in == 0) or
+more output room (avail_out == 0), or is done. Once LZUF_FINISH
+is passed, it stays. A flush point is out when a LZUF_SYNC_FLUSH
+step returns with avail_in == 0 and avail_out != 0. After an
+error, or the end, each step returns the same.
+*/
+int lzuf_step( lzuf_stream *s, int flush )
+{
+	lzuf_state *st = (lzuf_state *) s->state;
+	
+	if ( !st ) return LZUF_PARAM_ERROR;
+	if ( st->status == LZUF_OK ) {
+		if ( st->flush != LZUF_FINISH ) st->flush = flush;
+		st->status = st->decoding ? stream_decompress( s, st ) : stream_compress( s, st );
+	}
+	return st->status;
+}
+
+/* closes the stream, done or not; the rest of the output is dropped. */
+int lzuf_end( lzuf_stream *s )
+{
+	lzuf_state *st = (lzuf_state *) s->state;
+	
+	if ( !st ) return LZUF_PARAM_ERROR;
+	free( st->buf );
+	free( st->out );
+	free( st );
+	s->state = NULL;
+	return LZUF_OK;
+}
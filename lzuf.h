@@ -0,0 +1,83 @@
+/*
+	Filename:   LZUF.H
+	Author:     Gerald Tamayo
+	Date:       10/16/2026
+*/
+#include <stddef.h>
+#include <stdint.h>
+
+#if !defined( LZUF_H )
+	#define LZUF_H
+
+/* the returned size of a failed call. */
+#define LZUF_ERROR  ((size_t) -1)
+
+/* lzuf_step() flush modes. */
+#define LZUF_RUN      0
+#define LZUF_FINISH   1   /* no more input after next_in. */
+#define LZUF_SYNC_FLUSH 2   /* coder: all of the output so far, with the window kept. */
+
+/* lzuf_step() return codes. */
+#define LZUF_OK           0   /* needs more input, or more output room. */
+#define LZUF_STREAM_END   1   /* all of the output is out. */
+#define LZUF_DATA_ERROR  (-1)
+#define LZUF_MEM_ERROR   (-2)
+#define LZUF_PARAM_ERROR (-3)
+
+typedef struct {
+	int window_bits;   /* 12..20; 0 = default (17). */
+	int list_bits;     /* bitsize of the hash bucket search list, 1..12; 0 = default (9). */
+} lzuf_params;
+
+/*
+An incremental stream: each lzuf_step() takes what it can of
+next_in and fills what it can of next_out, then updates them.
+
+The coder writes the frames of "lzhhf5 -T -p": blocks of a few
+windows, each primed with the window before it. The decoder takes
+those of any -T file (not an -l archive); for the data of
+lzuf_compress(), and of "lzhhf5" without -T, it returns
+LZUF_PARAM_ERROR before any output: use lzuf_decompress(). Each
+block is coded or decoded whole within one step, on the caller's
+thread, so any number of streams may be open on any threads.
+*/
+typedef struct {
+	const unsigned char *next_in;
+	size_t avail_in;
+	int64_t total_in;
+	unsigned char *next_out;
+	size_t avail_out;
+	int64_t total_out;
+	void *state;       /* the library's. */
+} lzuf_stream;
+
+/*
+Decoded blocks kept for lzuf_cache_range(), least recently used
+out first; its readers may run on any number of threads.
+*/
+typedef struct {
+	size_t budget;     /* the most bytes of blocks kept, if none is in use. */
+	int64_t hits, misses;  /* blocks found in the cache, and decoded. */
+	void *state;       /* the library's. */
+} lzuf_cache;
+
+/* ---- function prototypes. ---- */
+size_t lzuf_compress_bound( size_t src_size );
+size_t lzuf_compress( const void *src, size_t src_size,
+	void *dst, size_t dst_cap, const lzuf_params *params );
+size_t lzuf_decompressed_size( const void *src, size_t src_size );
+size_t lzuf_decompress( const void *src, size_t src_size,
+	void *dst, size_t dst_cap );
+size_t lzuf_decompress_range( const void *src, size_t src_size,
+	int64_t offset, void *dst, size_t len );
+int lzuf_cache_init( lzuf_cache *c, size_t budget );
+size_t lzuf_cache_range( lzuf_cache *c, const void *src, size_t src_size,
+	int64_t offset, void *dst, size_t len );
+int lzuf_cache_forget( lzuf_cache *c, const void *src );
+int lzuf_cache_end( lzuf_cache *c );
+int lzuf_compress_init( lzuf_stream *s, const lzuf_params *params );
+int lzuf_decompress_init( lzuf_stream *s );
+int lzuf_step( lzuf_stream *s, int flush );
+int lzuf_end( lzuf_stream *s );
+
+#endif
@@ -0,0 +1,213 @@
+/*
+	Filename:   LZUFTEST.C
+	Author:     Gerald Tamayo
+	Date:       10/17/2026
+	
+	Checks the lzuf.c library on files:
+	
+	lzuftest file...           one-shot and stream round trips (with
+	                           small steps, and flush points);
+	lzuftest -c file out       stream-codes file into out, for "lzhhf5 -d";
+	lzuftest -d image file     stream-decodes image (e.g. of "lzhhf5 -T")
+	                           and compares it with file.
+	
+	Prints a line per check and returns 0 if all of them pass.
+	
+	gcc -O2 -o lzuftest lzuftest.c lzuf.c -lm -lpthread
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lzuf.h"
+
+static int nfailed = 0;
+
+static void check( int ok, const char *what, const char *name )
+{
+	printf( "%-6s %-28s %s\n", ok ? "OK" : "FAIL", what, name );
+	if ( !ok ) nfailed++;
+}
+
+/* reads the whole file; NULL if it can't. */
+static unsigned char *read_file( const char *name, size_t *n )
+{
+	FILE *f = fopen( name, "rb" );
+	unsigned char *p = NULL;
+	long len;
+	
+	if ( !f ) return NULL;
+	if ( fseek( f, 0, SEEK_END ) == 0 && (len = ftell( f )) >= 0 ) {
+		rewind( f );
+		if ( (p = (unsigned char *) malloc( (size_t) len + 1 )) != NULL
+				&& fread( p, 1, (size_t) len, f ) != (size_t) len ) {
+			free( p );
+			p = NULL;
+		}
+		*n = (size_t) len;
+	}
+	fclose( f );
+	return p;
+}
+
+/*
+Runs a stream over the n bytes at src, into dst (cap bytes), at
+most step bytes in and out per lzuf_step(); the coder ends with
+flush (LZUF_FINISH). Returns the last status; *out, the output size.
+*/
+static int run_stream( lzuf_stream *s, const unsigned char *src, size_t n,
+	unsigned char *dst, size_t cap, size_t step, int flush, size_t *out )
+{
+	size_t in = 0, room;
+	int status;
+	
+	do {
+		s->next_in = src + in;
+		s->avail_in = n - in < step ? n - in : step;
+		room = cap - (size_t) s->total_out;
+		s->next_out = dst + s->total_out;
+		s->avail_out = room < step ? room : step;
+		status = lzuf_step( s, in + s->avail_in == n ? flush : LZUF_RUN );
+		in = (size_t) s->total_in;
+	} while ( status == LZUF_OK && (in < n || s->avail_out == 0) && s->total_out < (int64_t) cap );
+	*out = (size_t) s->total_out;
+	return status;
+}
+
+static void test_file( const char *name )
+{
+	unsigned char *src, *z = NULL, *d = NULL;
+	size_t n, zn, dn, cap, half;
+	lzuf_params params;
+	lzuf_stream s;
+	int status;
+	
+	if ( (src = read_file( name, &n )) == NULL ) {
+		check( 0, "read", name );
+		return;
+	}
+	cap = lzuf_compress_bound( n ) + n/8 + 4096;  /* the frames of a stream too. */
+	z = (unsigned char *) malloc( cap );
+	d = (unsigned char *) malloc( n + 1 );
+	if ( !z || !d ) {
+		check( 0, "memory", name );
+		goto done;
+	}
+	
+	/* one-shot. */
+	params.window_bits = 16;
+	params.list_bits = 0;
+	zn = lzuf_compress( src, n, z, cap, &params );
+	dn = zn == LZUF_ERROR ? LZUF_ERROR : lzuf_decompress( z, zn, d, n );
+	check( dn == n && memcmp( d, src, n ) == 0, "one-shot", name );
+	
+	/* a one-shot image isn't framed: no stream output at all. */
+	if ( zn != LZUF_ERROR && lzuf_decompress_init( &s ) == LZUF_OK ) {
+		status = run_stream( &s, z, zn, d, n+1, 1<<16, LZUF_FINISH, &dn );
+		check( status == LZUF_PARAM_ERROR && dn == 0, "stream: plain image rejected", name );
+		lzuf_end( &s );
+	}
+	
+	/* a stream, with steps of 1000 bytes in and out. */
+	status = lzuf_compress_init( &s, NULL );
+	if ( status == LZUF_OK ) {
+		status = run_stream( &s, src, n, z, cap, 1000, LZUF_FINISH, &zn );
+		lzuf_end( &s );
+	}
+	if ( status == LZUF_STREAM_END && lzuf_decompress_init( &s ) == LZUF_OK ) {
+		status = run_stream( &s, z, zn, d, n, 777, LZUF_FINISH, &dn );
+		lzuf_end( &s );
+	}
+	check( status == LZUF_STREAM_END && dn == n && memcmp( d, src, n ) == 0, "stream", name );
+	
+	/* a flush point halfway: its output so far decodes to all of the input so far. */
+	half = n / 2;
+	status = lzuf_compress_init( &s, NULL );
+	if ( status == LZUF_OK ) {
+		status = run_stream( &s, src, half, z, cap, 1<<16, LZUF_SYNC_FLUSH, &zn );
+		lzuf_end( &s );
+	}
+	if ( status == LZUF_OK && lzuf_decompress_init( &s ) == LZUF_OK ) {
+		status = run_stream( &s, z, zn, d, n, 1<<16, LZUF_RUN, &dn );
+		lzuf_end( &s );
+	}
+	check( status == LZUF_OK && dn == half && memcmp( d, src, half ) == 0, "stream: flush point", name );
+	
+	done:
+	
+	free( src );
+	free( z );
+	free( d );
+}
+
+/* stream-codes name into out. */
+static void code_file( const char *name, const char *out )
+{
+	unsigned char in[ 1<<15 ], buf[ 1<<15 ];
+	FILE *f = fopen( name, "rb" ), *g = fopen( out, "wb" );
+	lzuf_stream s;
+	int status = LZUF_PARAM_ERROR, flush = LZUF_RUN;
+	
+	if ( f && g && (status = lzuf_compress_init( &s, NULL )) == LZUF_OK ) {
+		s.avail_in = 0;
+		do {
+			if ( s.avail_in == 0 && flush == LZUF_RUN ) {
+				s.next_in = in;
+				s.avail_in = fread( in, 1, sizeof(in), f );
+				if ( s.avail_in < sizeof(in) ) flush = LZUF_FINISH;
+			}
+			s.next_out = buf;
+			s.avail_out = sizeof(buf);
+			status = lzuf_step( &s, flush );
+			fwrite( buf, 1, sizeof(buf) - s.avail_out, g );
+		} while ( status == LZUF_OK );
+		lzuf_end( &s );
+	}
+	check( status == LZUF_STREAM_END, "stream: coded", name );
+	if ( f ) fclose( f );
+	if ( g ) fclose( g );
+}
+
+/* stream-decodes image, a piece at a time, and compares it with name. */
+static void decode_file( const char *image, const char *name )
+{
+	unsigned char *z, *src, buf[ 1<<15 ];
+	size_t zn, n, in = 0, out = 0, k;
+	lzuf_stream s;
+	int status = LZUF_PARAM_ERROR, same = 1;
+	
+	z = read_file( image, &zn );
+	src = read_file( name, &n );
+	if ( z && src && (status = lzuf_decompress_init( &s )) == LZUF_OK ) {
+		do {
+			s.next_in = z + in;
+			s.avail_in = zn - in < 5000 ? zn - in : 5000;
+			s.next_out = buf;
+			s.avail_out = sizeof(buf);
+			status = lzuf_step( &s, in + s.avail_in == zn ? LZUF_FINISH : LZUF_RUN );
+			in = (size_t) s.total_in;
+			k = sizeof(buf) - s.avail_out;
+			if ( out + k > n || memcmp( buf, src + out, k ) ) same = 0;
+			out += k;
+		} while ( status == LZUF_OK && same );
+		lzuf_end( &s );
+	}
+	check( status == LZUF_STREAM_END && same && out == n, "stream: decoded", image );
+	free( z );
+	free( src );
+}
+
+int main( int argc, char *argv[] )
+{
+	int i;
+	
+	if ( argc == 4 && !strcmp( argv[1], "-c" ) ) code_file( argv[2], argv[3] );
+	else if ( argc == 4 && !strcmp( argv[1], "-d" ) ) decode_file( argv[2], argv[3] );
+	else if ( argc > 1 && argv[1][0] != '-' ) {
+		for ( i = 1; i < argc; i++ ) test_file( argv[i] );
+	}
+	else {
+		fprintf(stderr, "\n Usage: lzuftest file... | -c file out | -d image file\n");
+		return 2;
+	}
+	return nfailed != 0;
+}
@@ -0,0 +1,109 @@
+#!/bin/sh
+#
+#	Filename:   LZUFTEST.SH
+#	Author:     Gerald Tamayo
+#	Date:       10/17/2026
+#
+#	Builds lzhhf5 and lzuftest (from a copy of the sources with
+#	lower-case names) and round-trips sample files in every mode:
+#	-c, -s, -t, pipes, -T (with -p, -b), -m, -l and -d -r, and the
+#	lzuf.c library. Checks that -T, -m and -l write the same bytes
+#	on 1 and on 8 threads.
+#
+#	sh lzuftest.sh [file...]   (default: the sources and programs here)
+#
+#	CC and CFLAGS may be set; prints a line per check, and exits
+#	with 1 if any of them fails.
+
+src=$(cd "$(dirname "$0")" && pwd)
+tmp=$(mktemp -d "${TMPDIR:-/tmp}/lzuftest.XXXXXX") || exit 1
+trap 'rm -rf "$tmp"' EXIT
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2}
+failed=0
+
+check()  # check ok|fail what
+{
+	if [ "$1" = ok ]; then printf 'OK     %s\n' "$2"; else printf 'FAIL   %s\n' "$2"; failed=1; fi
+}
+
+same()  # same file1 file2 what
+{
+	if cmp -s "$1" "$2"; then check ok "$3"; else check fail "$3"; fi
+}
+
+# ---- build ----
+mkdir "$tmp/src" "$tmp/in"
+for f in "$src"/*.c "$src"/*.C "$src"/*.h "$src"/*.H; do
+	[ -f "$f" ] && cp "$f" "$tmp/src/$(basename "$f" | tr 'A-Z' 'a-z')"
+done
+( cd "$tmp/src" && $CC $CFLAGS -o ../lzhhf5 lzhhf5.c -lm -lpthread \
+	&& $CC $CFLAGS -o ../lzuftest lzuftest.c lzuf.c -lm -lpthread ) || { echo "build failed"; exit 1; }
+z="$tmp/lzhhf5"
+
+# ---- the sample files ----
+if [ $# -eq 0 ]; then set -- "$src"/*.c "$src"/*.exe "$src"/Readme.txt; fi
+for f in "$@"; do cp "$f" "$tmp/in/"; done
+: > "$tmp/in/empty"
+i=0; while [ $i -lt 2000 ]; do echo "line $i of a repetitive file"; i=$((i+1)); done > "$tmp/in/lines"
+for i in 1 2 3 4; do cat "$tmp"/in/*; done > "$tmp/big"   # several blocks with -b1.
+
+# ---- each file, each mode ----
+for f in "$tmp"/in/* "$tmp/big"; do
+	n=$(basename "$f")
+	for mode in -c -c12 -c20 -s -t -T -T4 "-T -p" "-T -b1" "-T -p -b1" -m -m4; do
+		rm -f "$tmp/o.z" "$tmp/o"
+		$z $mode "$f" "$tmp/o.z" >/dev/null 2>&1
+		$z -d "$tmp/o.z" "$tmp/o" >/dev/null 2>&1
+		same "$f" "$tmp/o" "$mode $n"
+	done
+	cat "$f" | $z -c - - 2>/dev/null | $z -d - - 2>/dev/null > "$tmp/o"
+	same "$f" "$tmp/o" "pipe $n"
+	cat "$f" | $z -T -p - - 2>/dev/null | $z -d - - 2>/dev/null > "$tmp/o"
+	same "$f" "$tmp/o" "pipe -T -p $n"
+done
+
+# ---- the same bytes on any number of threads ----
+f="$tmp/big"
+for opts in "-T1 -b1:-T8 -b1" "-T1 -p -b1:-T8 -p -b1" "-m1:-m8"; do
+	$z ${opts%:*} "$f" "$tmp/a.z" >/dev/null 2>&1
+	$z ${opts#*:} "$f" "$tmp/b.z" >/dev/null 2>&1
+	same "$tmp/a.z" "$tmp/b.z" "${opts%:*} and ${opts#*:}: the same bytes"
+done
+if $z -T8 -b1 -v "$f" "$tmp/o.z" >/dev/null 2>&1; then check ok "-T -v"; else check fail "-T -v"; fi
+
+# ---- an archive of the files, and its extraction ----
+$z -l -T1 "$tmp/in" "$tmp/a.z" >/dev/null 2>&1
+$z -l -T8 "$tmp/in" "$tmp/b.z" >/dev/null 2>&1
+same "$tmp/a.z" "$tmp/b.z" "-l -T1 and -l -T8: the same bytes"
+( cd "$tmp" && ls -d in/* > list )
+( cd "$tmp" && $z -l list l.z >/dev/null 2>&1 && $z -d l.z out >/dev/null 2>&1 )
+for f in "$tmp"/in/*; do same "$f" "$tmp/out/in/$(basename "$f")" "-l list, -d $(basename "$f")"; done
+rm -rf "$tmp/out"
+$z -d "$tmp/b.z" "$tmp/out" >/dev/null 2>&1
+for f in "$tmp"/in/*; do same "$f" "$tmp/out/$(basename "$f")" "-l dir, -d $(basename "$f")"; done
+
+# ---- ranges of an indexed -T file ----
+f="$tmp/big"
+size=$(wc -c < "$f")
+$z -T -b1 "$f" "$tmp/r.z" >/dev/null 2>&1
+for r in 0,100 1048570,20 1000000,3000000 $((size-10)),100 $size,5; do
+	from=${r%,*}; len=${r#*,}
+	rm -f "$tmp/o"
+	$z -d -r$r "$tmp/r.z" "$tmp/o" >/dev/null 2>&1
+	tail -c +$((from+1)) "$f" | head -c $len > "$tmp/want"
+	same "$tmp/want" "$tmp/o" "-d -r$r"
+done
+
+# ---- the library ----
+"$tmp/lzuftest" "$tmp"/in/* "$tmp/big" || failed=1
+for mode in -T "-T -p" "-T -b1" "-T -p -b1"; do
+	$z $mode "$tmp/big" "$tmp/t.z" >/dev/null 2>&1
+	"$tmp/lzuftest" -d "$tmp/t.z" "$tmp/big" > /dev/null || { check fail "lzuf stream of $mode"; continue; }
+	check ok "lzuf stream of $mode"
+done
+"$tmp/lzuftest" -c "$tmp/big" "$tmp/s.z" > /dev/null && $z -d "$tmp/s.z" "$tmp/o" >/dev/null 2>&1
+same "$tmp/big" "$tmp/o" "lzuf stream, lzhhf5 -d"
+
+if [ $failed -ne 0 ]; then echo "some checks FAILED"; else echo "all checks passed"; fi
+exit $failed
@@ -7,8 +7,8 @@
 #include <string.h>
 #include "mtf.h"
 
-int tSIZE = 0;
-mtf_list_t *p = NULL, *head = NULL, *table = NULL;
+GT_TLS int tSIZE = 0;
+GT_TLS mtf_list_t *p = NULL, *head = NULL, *table = NULL;
 
 int alloc_mtf( int tsize )
 {
@@ -42,6 +42,7 @@ void init_mtf(void)
 void free_mtf_table( void )
 {
 	if ( table ) free( table );
+	table = head = NULL;
 }
 
 static inline int mtf( int c )
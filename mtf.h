@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "gttls.h"
 
 #ifndef MTF_H
 #define MTF_H
@@ -16,8 +17,8 @@ typedef struct mtf_list {
 	struct mtf_list *next;
 } mtf_list_t;
 
-extern int tSIZE;
-extern mtf_list_t *p, *head, *table;
+extern GT_TLS int tSIZE;
+extern GT_TLS mtf_list_t *p, *head, *table;
 
 int alloc_mtf( int size );
 void init_mtf( void );
@@ -62,7 +62,8 @@ static inline unsigned int get_vlcode( int len )
 {
 	unsigned int n = 0;
 	
-	while ( get_bit() ){
+	/* stops at end of file, or at a corrupt code too long for an int. */
+	while ( get_bit() == 1 && len < INT_BIT-1 ){
 		n += (1<<len++);
 	}
 	if ( len ) n += get_nbits(len);